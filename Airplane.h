@@ -1,29 +1,19 @@
 #pragma once
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <vector>
-#include <random>
-
-
-#define GLEW_STATIC 1
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "SimRandom.h"
+
 
 constexpr float TURN_ANGULAR_ACCEL = 40.f;   // deg/s^2
 constexpr float MAX_TURN_RATE      = 90.f;  // deg/s
 constexpr float LIFESPAN      = 30.f;
 
-
-inline float randomPick() {
-    static thread_local std::mt19937 rng(std::random_device{}());
-    static std::uniform_int_distribution<int> dist(-1, 1); // -1, 0, 1
-    return static_cast<float>(dist(rng));
-}
-
 class Airplane {
 private:
     bool alive{true};
@@ -57,8 +47,9 @@ public:
             // turnrate is deg/s -> angle this frame in radians
             const float deltaAngleRad = glm::radians(turnrate * dt);
             if (deltaAngleRad != 0.f) {
-                const glm::mat3 R = glm::mat3(glm::rotate(glm::mat4(1.f), deltaAngleRad, glm::vec3(0.f, 1.f, 0.f)));
-                vel = R * vel;
+                const float c = std::cos(deltaAngleRad);
+                const float s = std::sin(deltaAngleRad);
+                vel = glm::vec3(c * vel.x + s * vel.z, vel.y, c * vel.z - s * vel.x);
             }
 
             
@@ -0,0 +1,380 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "Airplane.h"
+#include "EntityPool.h"
+#include "EventQueue.h"
+#include "SimRandom.h"
+
+// Lane helpers for the fleet kernel. AVX2 builds advance 8 planes per step,
+// SSE2 builds 4; anything else falls back to the scalar loop.
+namespace fleet_simd {
+#if defined(__AVX2__)
+constexpr int WIDTH = 8;
+using vf = __m256;
+inline vf load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, vf a) { _mm256_storeu_ps(p, a); }
+inline vf set1(float a) { return _mm256_set1_ps(a); }
+inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+inline vf sub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+inline vf div(vf a, vf b) { return _mm256_div_ps(a, b); }
+inline vf min(vf a, vf b) { return _mm256_min_ps(a, b); }
+inline vf max(vf a, vf b) { return _mm256_max_ps(a, b); }
+inline vf gt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline vf ge(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline vf neq(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+inline vf andMask(vf a, vf b) { return _mm256_and_ps(a, b); }
+inline vf andNot(vf m, vf a) { return _mm256_andnot_ps(m, a); }
+inline vf xorBits(vf a, vf b) { return _mm256_xor_ps(a, b); }
+inline vf select(vf m, vf a, vf b) { return _mm256_blendv_ps(b, a, m); }
+inline int bits(vf m) { return _mm256_movemask_ps(m); }
+#elif defined(__SSE2__)
+constexpr int WIDTH = 4;
+using vf = __m128;
+inline vf load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, vf a) { _mm_storeu_ps(p, a); }
+inline vf set1(float a) { return _mm_set1_ps(a); }
+inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+inline vf sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+inline vf div(vf a, vf b) { return _mm_div_ps(a, b); }
+inline vf min(vf a, vf b) { return _mm_min_ps(a, b); }
+inline vf max(vf a, vf b) { return _mm_max_ps(a, b); }
+inline vf gt(vf a, vf b) { return _mm_cmpgt_ps(a, b); }
+inline vf ge(vf a, vf b) { return _mm_cmpge_ps(a, b); }
+inline vf neq(vf a, vf b) { return _mm_cmpneq_ps(a, b); }
+inline vf andMask(vf a, vf b) { return _mm_and_ps(a, b); }
+inline vf andNot(vf m, vf a) { return _mm_andnot_ps(m, a); }
+inline vf xorBits(vf a, vf b) { return _mm_xor_ps(a, b); }
+inline vf select(vf m, vf a, vf b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline int bits(vf m) { return _mm_movemask_ps(m); }
+#else
+constexpr int WIDTH = 1;
+#endif
+} // namespace fleet_simd
+
+// Structure-of-arrays copy of Airplane for running large AI fleets.
+// update() advances the whole fleet with the SIMD kernel; updateScalar() is
+// the reference path and follows Airplane::update operation for operation.
+// Capacity is fixed at construction and slots are generation-checked, so
+// handles stay stable and dead planes are reused without allocating.
+// Arrays are padded to a multiple of the SIMD width with dead slots.
+class AirplaneFleet {
+private:
+    SlotAllocator slots;
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> prevX, prevY, prevZ;   // position at the start of the last step
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> roll;             // degrees
+    std::vector<float> turnrate;         // deg/s, yaw rate
+    std::vector<float> currentTurnDir;   // -1, 0, or 1
+    std::vector<float> dirTimer;         // seconds since last change
+    std::vector<float> age;
+    std::vector<float> alive;            // 1 or 0, float so it loads as a lane mask
+
+    // per-slot results of the last integrate, applied serially in finishStep()
+    // so disjoint slot ranges can be integrated on different threads
+    enum : std::uint8_t { STEP_REROLL = 1, STEP_EXPIRED = 2 };
+    std::vector<std::uint8_t> events;
+
+    SimRng rng;                      // spawn jitter and turn re-rolls
+    std::vector<float> turnPicks;    // scratch: one batch of re-rolls per step
+
+    std::array<std::vector<float>*, 15> stateArrays() {
+        return { &posX, &posY, &posZ, &prevX, &prevY, &prevZ, &velX, &velY, &velZ,
+                 &roll, &turnrate, &currentTurnDir, &dirTimer, &age, &alive };
+    }
+
+    void resizeArrays(std::size_t n) {
+        for (auto* a : stateArrays()) a->resize(n, 0.f);
+        events.resize(n, 0);
+    }
+
+    void integrateScalar(float dt, std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            if (alive[i] == 0.f) continue;
+            prevX[i] = posX[i];
+            prevY[i] = posY[i];
+            prevZ[i] = posZ[i];
+            posX[i] += velX[i] * dt;
+            posY[i] += velY[i] * dt;
+            posZ[i] += velZ[i] * dt;
+            age[i] += dt;
+            if (age[i] > LIFESPAN) {
+                alive[i] = 0.f;
+                events[i] = STEP_EXPIRED;
+                continue;
+            }
+
+            const float deltaAngleRad = glm::radians(turnrate[i] * dt);
+            if (deltaAngleRad != 0.f) {
+                const float c = std::cos(deltaAngleRad);
+                const float s = std::sin(deltaAngleRad);
+                const float vx = velX[i], vz = velZ[i];
+                velX[i] = c * vx + s * vz;
+                velZ[i] = c * vz - s * vx;
+            }
+
+            roll[i] = -(turnrate[i] / MAX_TURN_RATE) * 60.f;
+
+            turnrate[i] = std::clamp(turnrate[i] + TURN_ANGULAR_ACCEL * dt * currentTurnDir[i],
+                                     -MAX_TURN_RATE, MAX_TURN_RATE);
+
+            dirTimer[i] += dt;
+            if (dirTimer[i] >= .5f) {
+                events[i] = STEP_REROLL;
+                dirTimer[i] = 0.f;
+            }
+        }
+    }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // sin/cos on [-pi/2, pi/2]; a yaw step stays inside that range for any
+    // dt up to MAX_POLY_STEP, and longer steps use libm instead
+    static void sinCosPoly(fleet_simd::vf x, fleet_simd::vf& s, fleet_simd::vf& c) {
+        using namespace fleet_simd;
+        const vf x2 = mul(x, x);
+        vf ps = set1(2.7557319e-6f);
+        ps = add(mul(ps, x2), set1(-1.9841270e-4f));
+        ps = add(mul(ps, x2), set1(8.3333333e-3f));
+        ps = add(mul(ps, x2), set1(-1.6666667e-1f));
+        s = add(x, mul(mul(ps, x2), x));
+        vf pc = set1(-2.7557319e-7f);
+        pc = add(mul(pc, x2), set1(2.4801587e-5f));
+        pc = add(mul(pc, x2), set1(-1.3888889e-3f));
+        pc = add(mul(pc, x2), set1(4.1666667e-2f));
+        pc = add(mul(pc, x2), set1(-0.5f));
+        c = add(set1(1.f), mul(pc, x2));
+    }
+
+    // lo and hi must be multiples of WIDTH
+    void integrateSimd(float dt, bool exactTrig, std::size_t lo, std::size_t hi) {
+        using namespace fleet_simd;
+        const vf vdt = set1(dt);
+        const vf zero = set1(0.f);
+        const vf signBit = set1(-0.f);
+        const vf lifespan = set1(LIFESPAN);
+        const vf degToRad = set1(glm::radians(1.f));
+        const vf maxRate = set1(MAX_TURN_RATE);
+        const vf minRate = set1(-MAX_TURN_RATE);
+        const vf rollScale = set1(60.f);
+        const vf accelDt = set1(TURN_ANGULAR_ACCEL * dt);
+        const vf dirPeriod = set1(.5f);
+        float sArr[WIDTH], cArr[WIDTH], angArr[WIDTH];
+
+        for (std::size_t i = lo; i < hi; i += WIDTH) {
+            const vf live = gt(load(&alive[i]), zero);
+            if (bits(live) == 0) continue;
+
+            const vf vx = load(&velX[i]), vy = load(&velY[i]), vz = load(&velZ[i]);
+            const vf px = load(&posX[i]), py = load(&posY[i]), pz = load(&posZ[i]);
+            store(&prevX[i], select(live, px, load(&prevX[i])));
+            store(&prevY[i], select(live, py, load(&prevY[i])));
+            store(&prevZ[i], select(live, pz, load(&prevZ[i])));
+            store(&posX[i], select(live, add(px, mul(vx, vdt)), px));
+            store(&posY[i], select(live, add(py, mul(vy, vdt)), py));
+            store(&posZ[i], select(live, add(pz, mul(vz, vdt)), pz));
+            const vf a = select(live, add(load(&age[i]), vdt), load(&age[i]));
+            store(&age[i], a);
+
+            const vf dying = andMask(live, gt(a, lifespan));
+            store(&alive[i], andNot(dying, load(&alive[i])));
+            const vf run = andNot(dying, live);
+            int dyingBits = bits(dying);
+            for (int l = 0; dyingBits != 0; ++l, dyingBits >>= 1)
+                if (dyingBits & 1) events[i + l] = STEP_EXPIRED;
+
+            // yaw rotation about global Y
+            const vf tr = load(&turnrate[i]);
+            const vf ang = mul(mul(tr, vdt), degToRad);
+            vf s, c;
+            if (exactTrig || dt > MAX_POLY_STEP) {
+                store(angArr, ang);
+                for (int l = 0; l < WIDTH; ++l) {
+                    sArr[l] = std::sin(angArr[l]);
+                    cArr[l] = std::cos(angArr[l]);
+                }
+                s = load(sArr);
+                c = load(cArr);
+            } else {
+                sinCosPoly(ang, s, c);
+            }
+            const vf turn = andMask(run, neq(ang, zero));
+            store(&velX[i], select(turn, add(mul(c, vx), mul(s, vz)), vx));
+            store(&velZ[i], select(turn, sub(mul(c, vz), mul(s, vx)), vz));
+
+            // bank roll and turn-rate clamp
+            const vf r = mul(xorBits(div(tr, maxRate), signBit), rollScale);
+            store(&roll[i], select(run, r, load(&roll[i])));
+            const vf nextRate = min(max(add(tr, mul(accelDt, load(&currentTurnDir[i]))), minRate), maxRate);
+            store(&turnrate[i], select(run, nextRate, tr));
+
+            // direction timer
+            const vf timer = add(load(&dirTimer[i]), vdt);
+            const vf due = andMask(run, ge(timer, dirPeriod));
+            store(&dirTimer[i], select(run, andNot(due, timer), load(&dirTimer[i])));
+            int dueBits = bits(due);
+            for (int l = 0; dueBits != 0; ++l, dueBits >>= 1)
+                if (dueBits & 1) events[i + l] = STEP_REROLL;
+        }
+    }
+#endif
+
+    // Test mode step for [lo, hi): the scalar path runs first, then the
+    // state is rolled back and the SIMD kernel runs from the same start, and
+    // the two results are compared bitwise. Only the range is touched, so
+    // blocks can be checked on any thread.
+    void integrateVerified(float dt, std::size_t lo, std::size_t hi) {
+        const auto arrays = stateArrays();
+        const std::size_t n = hi - lo;
+        std::vector<float> start(arrays.size() * n), scalar(arrays.size() * n);
+        for (std::size_t k = 0; k < arrays.size(); ++k)
+            std::copy(arrays[k]->begin() + lo, arrays[k]->begin() + hi, start.begin() + k * n);
+        const std::vector<std::uint8_t> startEvents(events.begin() + lo, events.begin() + hi);
+
+        integrateScalar(dt, lo, hi);
+        for (std::size_t k = 0; k < arrays.size(); ++k) {
+            std::copy(arrays[k]->begin() + lo, arrays[k]->begin() + hi, scalar.begin() + k * n);
+            std::copy(start.begin() + k * n, start.begin() + (k + 1) * n, arrays[k]->begin() + lo);
+        }
+        const std::vector<std::uint8_t> scalarEvents(events.begin() + lo, events.begin() + hi);
+        std::copy(startEvents.begin(), startEvents.end(), events.begin() + lo);
+
+        integrateSimd(dt, true, lo, hi);
+        bool same = std::equal(scalarEvents.begin(), scalarEvents.end(), events.begin() + lo);
+        for (std::size_t k = 0; k < arrays.size() && same; ++k)
+            same = n == 0 || std::memcmp(&(*arrays[k])[lo], &scalar[k * n], n * sizeof(float)) == 0;
+        if (!same) {
+            verifyMismatches.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "AirplaneFleet: SIMD kernel diverged from scalar path in slots " << lo << "-" << hi << "\n";
+        }
+    }
+
+public:
+    // longest step the SIMD kernel's polynomial sin/cos covers: a yaw turn
+    // of at most 90 degrees at MAX_TURN_RATE
+    static constexpr float MAX_POLY_STEP = 90.f / MAX_TURN_RATE;
+
+    // Test mode (--verify-simd in HeadlessSim.h): every update() and
+    // integrateBlocks() also runs the scalar path and counts the blocks
+    // whose results differ by a single bit. The SIMD kernel then uses libm
+    // sin/cos. Build without FP contraction (no -mfma, or -ffp-contract=off).
+    bool verifyAgainstScalar{false};
+    std::atomic<std::size_t> verifyMismatches{0};
+
+    // the same seed and the same spawn/kill sequence replay the same flights
+    explicit AirplaneFleet(std::uint32_t capacity, std::uint64_t seed = SimSeed())
+        : slots(capacity), rng(seed)
+    {
+        const std::size_t w = fleet_simd::WIDTH;
+        resizeArrays((capacity + w - 1) / w * w);
+        turnPicks.resize(capacity);
+    }
+
+    // returns an invalid handle when the fleet is full
+    EntityHandle spawn(const glm::vec3& startPos) {
+        const EntityHandle h = slots.acquire();
+        if (!h.valid()) return h;
+        const std::size_t i = h.index;
+        posX[i] = startPos.x; posY[i] = startPos.y; posZ[i] = startPos.z;
+        prevX[i] = startPos.x; prevY[i] = startPos.y; prevZ[i] = startPos.z;
+        velX[i] = 3.f * rng.pick(); velY[i] = 0.f; velZ[i] = 15.f;
+        roll[i] = 0.f;
+        turnrate[i] = 0.f;
+        currentTurnDir[i] = 0.f;
+        dirTimer[i] = 0.f;
+        age[i] = 0.f;
+        alive[i] = 1.f;
+        return h;
+    }
+
+    void update(float dt, EventQueue* eventQueue = nullptr) {
+        const std::size_t end = blockCount() * fleet_simd::WIDTH;
+#if defined(__AVX2__) || defined(__SSE2__)
+        if (verifyAgainstScalar) integrateVerified(dt, 0, end);
+        else integrateSimd(dt, false, 0, end);
+#else
+        integrateScalar(dt, 0, end);
+#endif
+        finishStep(eventQueue);
+    }
+
+    void updateScalar(float dt, EventQueue* eventQueue = nullptr) {
+        integrateScalar(dt, 0, blockCount() * fleet_simd::WIDTH);
+        finishStep(eventQueue);
+    }
+
+    // Split form of update() for the job system: integrateBlocks() on
+    // disjoint block ranges (any thread), then finishStep() once.
+    std::size_t blockCount() const {
+        return (slots.slotRange() + fleet_simd::WIDTH - 1) / fleet_simd::WIDTH;
+    }
+
+    void integrateBlocks(float dt, std::size_t firstBlock, std::size_t lastBlock) {
+        const std::size_t lo = firstBlock * fleet_simd::WIDTH, hi = lastBlock * fleet_simd::WIDTH;
+#if defined(__AVX2__) || defined(__SSE2__)
+        if (verifyAgainstScalar) integrateVerified(dt, lo, hi);
+        else integrateSimd(dt, false, lo, hi);
+#else
+        integrateScalar(dt, lo, hi);
+#endif
+    }
+
+    // turn re-rolls and slot release, in slot order; expiries are reported
+    // to eventQueue when given
+    void finishStep(EventQueue* eventQueue = nullptr) {
+        const std::size_t count = slots.slotRange();
+        std::size_t rerolls = 0;
+        for (std::size_t i = 0; i < count; ++i) rerolls += (events[i] == STEP_REROLL);
+        rng.fillPicks(turnPicks.data(), rerolls);   // -1, 0, or 1
+
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (events[i] == 0) continue;
+            if (events[i] == STEP_REROLL) {
+                currentTurnDir[i] = turnPicks[next++];
+            } else {
+                if (eventQueue) eventQueue->push(SimEvent{ SimEvent::PLANE_EXPIRED, handleAt(i), 0, position(i) });
+                slots.release(static_cast<std::uint32_t>(i));
+            }
+            events[i] = 0;
+        }
+    }
+
+    void kill(std::size_t i) {
+        alive[i] = 0.f;
+        slots.release(static_cast<std::uint32_t>(i));
+    }
+    void kill(const EntityHandle& h) {
+        if (slots.contains(h)) kill(h.index);
+    }
+
+    bool contains(const EntityHandle& h) const { return slots.contains(h); }
+    EntityHandle handleAt(std::size_t i) const { return slots.handleAt(static_cast<std::uint32_t>(i)); }
+
+    // index range to iterate; slots in it may be dead, check isAlive()
+    std::size_t size() const { return slots.slotRange(); }
+    std::size_t liveCount() const { return slots.liveCount(); }
+    glm::vec3 position(std::size_t i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+    glm::vec3 previousPosition(std::size_t i) const { return glm::vec3(prevX[i], prevY[i], prevZ[i]); }
+    // alpha in [0, 1] between the last two sim states
+    glm::vec3 interpolatedPosition(std::size_t i, float alpha) const { return glm::mix(previousPosition(i), position(i), alpha); }
+    glm::vec3 velocity(std::size_t i) const { return glm::vec3(velX[i], velY[i], velZ[i]); }
+    float bankRollDeg(std::size_t i) const { return roll[i]; }
+    bool isAlive(std::size_t i) const { return alive[i] != 0.f; }
+};
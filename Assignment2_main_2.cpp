@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 #define GLEW_STATIC 1
@@ -11,13 +13,33 @@
 
 #include "shaderloader.h"
 #include "Airplane.h"
+#include "AirplaneFleet.h"
+#include "BudgetGovernor.h"
 #include "Bullet.h"
+#include "BulletPool.h"
+#include "Collision.h"
+#include "CommandLine.h"
+#include "EventQueue.h"
+#include "Frustum.h"
+#include "GLState.h"
+#include "HeadlessSim.h"
+#include "JobSystem.h"
+#include "RenderQueue.h"
+#include "ShadowCascades.h"
+#include "SimClock.h"
+#include "SimWorld.h"
+#include "UniformBlocks.h"
 #include "utils.hpp"       // <— new helpers
 
 using namespace glm;
 using namespace std;
 
 const GLuint WIDTH = 1024, HEIGHT = 768;
+const uint32_t MAX_PLANES = 256, MAX_BULLETS = 1024;
+const float SIM_TICK_HZ = 60.f;
+const int MAX_SIM_STEPS_PER_FRAME = 5;
+const float FRAME_BUDGET_MS = 8.f;
+const float BULLET_SIZE = 0.1f;   // world-space sprite size, same as the old brass cube
 
 GLFWwindow* window = nullptr;
 bool InitContext();
@@ -26,15 +48,55 @@ vec3 computeCameraLookAt(double &lastMousePosX, double &lastMousePosY, float dt)
 
 
 int main(int argc, char* argv[]) {
+
+  for (int i = 1; i < argc; ++i)
+    if (string(argv[i]) == "--headless-sim") return RunHeadlessSim(argc, argv);
+
+  float simTickHz = SIM_TICK_HZ;
+  float frameBudgetMs = FRAME_BUDGET_MS;
+  int pcfTaps = 4;   // shadow lookups per test: 1, 4 or 16
+  for (int i = 1; i + 1 < argc; ++i) {
+    const string arg(argv[i]);
+    const char* value = argv[i + 1];
+    std::uint64_t seed = 0;
+    bool ok = true;
+    // out-of-range tick rates are clamped by SimClock (ClampTickRate)
+    if (arg == "--sim-hz") ok = ParseFloatArg(value, simTickHz);
+    if (arg == "--seed") {
+      ok = ParseUnsignedArg(value, std::numeric_limits<std::uint64_t>::max(), seed);
+      if (ok) SetSimSeed(seed);
+    }
+    if (arg == "--frame-budget-ms") ok = ParseFloatArg(value, frameBudgetMs) && frameBudgetMs > 0.f;
+    if (arg == "--pcf") {
+      long taps = 0;
+      ok = ParseIntArg(value, taps) && (taps == 1 || taps == 4 || taps == 16);
+      if (ok) pcfTaps = int(taps);
+    }
+    if (!ok) {
+      std::cerr << arg << ": not a valid value: \"" << value << "\"\n";
+      return 1;
+    }
+  }
   
   if (!InitContext()) return -1;
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
   std::string shaderPathPrefix = "Shaders/";
   GLuint shaderScene  = loadSHADER(shaderPathPrefix + "scene_vertex.glsl",
-                                   shaderPathPrefix + "scene_fragment.glsl");
-  GLuint shaderShadow = loadSHADER(shaderPathPrefix + "shadow_vertex.glsl",
-                                   shaderPathPrefix + "shadow_fragment.glsl");
+                                   shaderPathPrefix + "scene_fragment.glsl", "#define SUN_CASCADES\n");
+  // the same without the floodlight, used while it's switched off
+  GLuint shaderSceneSun = loadSHADER(shaderPathPrefix + "scene_vertex.glsl",
+                                     shaderPathPrefix + "scene_fragment.glsl",
+                                     "#define SUN_CASCADES\n#define NO_FLOODLIGHT\n");
+  // fills every layer of a shadow map array in one pass, see RenderQueue::flushLayers
+  GLuint shaderShadowLayered = loadSHADERWithGeometry(shaderPathPrefix + "shadow_vertex.glsl",
+                                                      shaderPathPrefix + "shadow_geometry.glsl",
+                                                      shaderPathPrefix + "shadow_fragment.glsl", "#define LAYERED\n");
+  GLuint shaderBullet = loadSHADER(shaderPathPrefix + "bullet_vertex.glsl",
+                                   shaderPathPrefix + "bullet_fragment.glsl");
+  for (GLuint shader : { shaderScene, shaderSceneSun, shaderShadowLayered, shaderBullet }) BindUniformBlocks(shader);
+  UniformBuffer frameBuffer(FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+  UniformBuffer lightBuffer(LIGHT_UNIFORMS_BINDING, sizeof(LightUniforms));
 
   // Models
   string planePath = "Models/airplane3.obj";
@@ -45,13 +107,11 @@ int main(int argc, char* argv[]) {
   utils::Mesh tankMesh = utils::SetupModelVBO(tankPath);
   utils::Mesh floorMesh = utils::SetupModelVBO(cubePath);
   utils::Mesh cubeMesh = utils::SetupModelVBO(cubePath);
-  utils::Mesh bulletMesh = utils::SetupModelVBO(cubePath);
   utils::Mesh planeMesh = utils::SetupModelVBO(planePath);
   utils::Mesh propMesh  = utils::SetupModelVBO(propPath);
   utils::PlaneMeshes meshes{ planeMesh, propMesh };
 
   string floorTexturePath = "Textures/desert.jpg";
-  string bulletTexturePath = "Textures/brass.jpg";
   string tankTexturePath = "Textures/camo2.jpg";
   string planeTexturePath = "Textures/camo2.jpg";
   string propTexturePath = "Textures/steel.png";
@@ -60,15 +120,21 @@ int main(int argc, char* argv[]) {
   
   cubeMesh.texture = utils::LoadTexture2D(cubeTexturePath);
   tankMesh.texture = utils::LoadTexture2D(tankTexturePath);
-  bulletMesh.texture = utils::LoadTexture2D(bulletTexturePath);
   meshes.plane.texture = utils::LoadTexture2D(planeTexturePath);
   meshes.prop.texture  = utils::LoadTexture2D(propTexturePath);
   floorMesh.texture = utils::LoadTexture2D(floorTexturePath);
 
   // depth map for shadows
-  const unsigned int DEPTH_MAP_TEXTURE_SIZE = 1440;
-  utils::DepthMap depth = utils::CreateDepthMap(DEPTH_MAP_TEXTURE_SIZE);
-  utils::DepthMap depthCam  = utils::CreateDepthMap(DEPTH_MAP_TEXTURE_SIZE);
+  const unsigned int DEPTH_MAP_TEXTURE_SIZE = 1024;   // filtered lookups hide the coarser texels
+  // one layer per spotlight; the floodlight is the only one so far, in layer 0
+  const int MAX_SPOT_SHADOWS = 4;
+  const int FLOODLIGHT_LAYER = 0;
+  utils::DepthMapArray spotShadowMaps = utils::CreateDepthMapArray(DEPTH_MAP_TEXTURE_SIZE, MAX_SPOT_SHADOWS);
+  // the sun's cascades, one layer each (4 x 640^2 texels against the old single 1440^2 map)
+  const unsigned int SUN_CASCADE_SIZE = 640;
+  utils::DepthMapArray sunCascadeMaps = utils::CreateDepthMapArray(SUN_CASCADE_SIZE, SUN_CASCADE_COUNT);
+  // the same with only the static casters in them, copied into sunCascadeMaps before the moving ones are drawn
+  utils::DepthMapArray sunStaticMaps = utils::CreateDepthMapArray(SUN_CASCADE_SIZE, SUN_CASCADE_COUNT);
 
 
   vec3 cameraPosition(0.6f, 2.f, 2.0f);
@@ -81,41 +147,60 @@ int main(int argc, char* argv[]) {
 
   mat4 tankViewMatrix = lookAt(tankPosition, tankPosition + tankLookAt, vec3(0,1,0));
   float tankYaw = std::atan2(tankLookAt.x, -tankLookAt.z); 
+  vec3 prevTankPosition = tankPosition;
+  float prevTankYaw = tankYaw;
   const float TANK_SPEED = 10.0f;                          
   const float TANK_TURN_SPEED = glm::radians(90.0f); 
 
 
-  mat4 projectionMatrix = perspective(radians(75.0f), WIDTH * 1.0f / HEIGHT, 0.01f, 400.0f);
+  const float cameraFovY = radians(75.0f), cameraAspect = WIDTH * 1.0f / HEIGHT, cameraNear = 0.01f;
+  mat4 projectionMatrix = perspective(cameraFovY, cameraAspect, cameraNear, 400.0f);
   mat4 viewMatrix = lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
 
 
-  utils::SetUniformMat4(shaderScene, "projection_matrix", projectionMatrix);
-  utils::SetUniformMat4(shaderScene, "view_matrix", viewMatrix);
+  // per-frame block contents; matrices and positions are filled in every frame
+  FrameUniforms frameUniforms;
+  frameUniforms.projection = projectionMatrix;
+  LightUniforms lightUniforms;
+
+  // the sun doesn't move; it lights from lightPosition, and casts shadows
+  // along lightDirection through cascades fitted to the camera each frame
+  vec3 lightPosition = vec3(30.f,60.0f,5.0f);
+  vec3 lightFocus(0, 0, -1);
+  vec3 lightDirection = normalize(lightFocus - lightPosition);
+  const float SHADOW_DISTANCE = 150.0f;   // as deep as the old sun frustum
+  SunCascades sunCascades(lightDirection, cameraNear, SHADOW_DISTANCE, SUN_CASCADE_SIZE);
+  frameUniforms.sunCascadeSplits = sunCascades.splitFars();
+  lightUniforms.sun.position = lightPosition;
+  lightUniforms.sun.direction = lightDirection;
 
   float lightAngleOuter = radians(100.0f);
   float lightAngleInner = radians(99.0f);
-  utils::SetUniform1f(shaderScene, "light_cutoff_inner", cos(lightAngleInner));
-  utils::SetUniform1f(shaderScene, "light_cutoff_outer", cos(lightAngleOuter));
-  utils::SetUniformVec3(shaderScene, "light_color", vec3(1.f, 1.f, .95f));
-  utils::SetUniformVec3(shaderScene, "object_color", vec3(1));
-
-  
-
-  // tell shader which texture units to use
-  utils::SetUniform1i(shaderScene, "albedo_tex", 0); // albedo on unit 0
-  utils::SetUniform1i(shaderScene, "shadow_map", 1); // shadow map on unit 1
-  utils::SetUniform1i(shaderScene, "cam_shadow_map", 2); // floodlight shadow map on unit 2
+  lightUniforms.sun.intensity = 1.f;
+  lightUniforms.sun.cutoffInner = cos(lightAngleInner);
+  lightUniforms.sun.cutoffOuter = cos(lightAngleOuter);
+  lightUniforms.sun.color = vec3(1.f, 1.f, .95f);
+  for (GLuint shader : { shaderScene, shaderSceneSun }) {
+    utils::SetUniformVec3(shader, "object_color", vec3(1));
+
+    // tell shader which texture units to use
+    utils::SetUniform1i(shader, "albedo_tex", 0); // albedo on unit 0
+    utils::SetUniform1i(shader, "shadow_map", 1); // shadow map on unit 1
+    utils::SetUniform1i(shader, "spot_shadow_maps", 2); // spotlight shadow maps on unit 2
+    utils::SetUniform1i(shader, "pcf_taps", pcfTaps);
+  }
 
   // for camera floodlight
-  utils::SetUniformVec3(shaderScene, "camLight_color", vec3(1.0f, 1.0f, 0.6f));
-  utils::SetUniform1f (shaderScene, "camLight_cutoff_inner", cos(radians(10.0f)));
-  utils::SetUniform1f (shaderScene, "camLight_cutoff_outer", cos(radians(14.0f)));
-  utils::SetUniform1f (shaderScene, "camLight_intensity",    6.0f);
+  lightUniforms.floodlight.color = vec3(1.0f, 1.0f, 0.6f);
+  lightUniforms.floodlight.cutoffInner = cos(radians(10.0f));
+  lightUniforms.floodlight.cutoffOuter = cos(radians(14.0f));
 
 
     glm::mat4 camLightProj = glm::perspective(glm::radians(14.f * 2.0f), 1.0f, 0.3f, 80.f);
-    glm::mat4 camLightView = glm::lookAt(cameraPosition + vec3(0.f, 2.f, 0.f), cameraPosition + vec3(0.f, 2.f, 0.f) + cameraLookAt, cameraUp);
-    glm::mat4 camLightProjView = camLightProj * camLightView;
+    // the floodlight's layer of spotShadowMaps holds its map for this signature (RenderQueue::signature), 0 for none
+    uint64_t floodlightShadowKey = 0;
+    uint64_t staticShadowKeys[SUN_CASCADE_COUNT] = {};   // likewise for each layer of sunStaticMaps
+    unsigned frameIndex = 0;
 
 
   float lastFrameTime = glfwGetTime();
@@ -123,11 +208,26 @@ int main(int argc, char* argv[]) {
   double lastMousePosX, lastMousePosY;
   glfwGetCursorPos(window, &lastMousePosX, &lastMousePosY);
 
-  glEnable(GL_DEPTH_TEST);
+  GLState::SetCapability(GL_DEPTH_TEST, true);
 
   // Make some planes
-  std::vector<Airplane> planes;
-  std::vector<Bullet> bullets;
+  JobSystem jobs;
+  SimWorld world(MAX_PLANES, MAX_BULLETS, &jobs);
+  AirplaneFleet& planes = world.planes;
+  BulletPool& bullets = world.bullets;
+  // static scenery bullets can hit, from the same bounds and transforms they're drawn with
+  world.staticWorld.add(utils::BuildFloorBaseModel(), floorMesh.localMin, floorMesh.localMax);
+  world.staticWorld.add(utils::BuildCubeModel(), cubeMesh.localMin, cubeMesh.localMax);
+  world.staticWorld.build();
+  std::vector<mat4> planeModels(MAX_PLANES);
+  RenderQueue renderQueue(2 * MAX_PLANES + 16);   // a plane and a propeller each, plus scenery
+  std::vector<vec3> bulletSprites(MAX_BULLETS);
+  utils::SpriteBuffer bulletSpriteBuffer = utils::CreateSpriteBuffer(MAX_BULLETS);
+  utils::SetUniform1f(shaderBullet, "bullet_size", BULLET_SIZE);
+  utils::SetUniformVec3(shaderBullet, "bullet_color", vec3(0.9f, 0.7f, 0.3f));
+  JobCounter planeModelsDone;
+  SlotSet drawPlanes(MAX_PLANES);   // kept up to date from sim events
+  unsigned score = 0;
   
 
   float propSpinDeg = 0.f;
@@ -135,143 +235,225 @@ int main(int argc, char* argv[]) {
   float gunCDTimer = 0.f;
 
   bool floodLightOn = false;
+
+  SimClock simClock(simTickHz, MAX_SIM_STEPS_PER_FRAME);
+  BudgetGovernor governor(frameBudgetMs, BudgetLimits{ 8, MAX_PLANES, 64, MAX_BULLETS, 0.5f, 4.f });
+  float statsTimer = 0.f;
   
 
   while (!glfwWindowShouldClose(window)) {
     float dt = glfwGetTime() - lastFrameTime;
     lastFrameTime = glfwGetTime();
+    const double frameStart = lastFrameTime;
+    GLState::BeginFrame();
     propSpinDeg += 45.f * dt;
-    
-    if (planeSpawnTimer > 4.f){
-      planes.emplace_back(glm::vec3(10.f, 20.f, -30.f));
-      planes.emplace_back(glm::vec3(-8.f, 23.f, -25.f));
-      planeSpawnTimer = 0.f;
-      
-    }
-    planeSpawnTimer += dt;
-    
-
 
-    vec3 lightPosition = vec3(30.f,60.0f,5.0f);
-    vec3 lightFocus(0, 0, -1);
-    vec3 lightDirection = normalize(lightFocus - lightPosition);
-    float lightNearPlane = 1.f, lightFarPlane = 150.0f;
-    mat4 lightProjMatrix = perspective(radians(80.0f),
-      (float)DEPTH_MAP_TEXTURE_SIZE /(float)DEPTH_MAP_TEXTURE_SIZE,
-      lightNearPlane, lightFarPlane);
-    mat4 lightViewMatrix = lookAt(lightPosition, lightFocus, vec3(0,1,0));
-    mat4 lightProjView   = lightProjMatrix * lightViewMatrix;
+    // SIMULATION (fixed step, input held this frame applies to every step)
+    const double simStart = glfwGetTime();
+    const int simSteps = simClock.advance(dt);
+    const float simDt = simClock.stepSeconds();
+    for (int step = 0; step < simSteps; ++step) {
+      prevTankPosition = tankPosition;
+      prevTankYaw = tankYaw;
+
+      if (planeSpawnTimer > governor.spawnInterval()){
+        if (governor.allowPlane(planes.liveCount())) world.spawnPlane(glm::vec3(10.f, 20.f, -30.f));
+        if (governor.allowPlane(planes.liveCount())) world.spawnPlane(glm::vec3(-8.f, 23.f, -25.f));
+        planeSpawnTimer = 0.f;
+      }
+      planeSpawnTimer += simDt;
+
+      world.step(simDt);   // integrate, collide, apply hits, log events
+
+      if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) tankYaw += TANK_TURN_SPEED * simDt;
+      if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) tankYaw -= TANK_TURN_SPEED * simDt;
+      glm::vec3 tankForward = glm::vec3(std::sin(tankYaw), 0.0f, -std::cos(tankYaw));
+
+      if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) tankPosition += tankForward * (TANK_SPEED * simDt);
+      if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) tankPosition -= tankForward * (TANK_SPEED * simDt);
+      if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && gunCDTimer > 0.2f
+          && governor.allowBullet(bullets.size())) {
+        vec3 gunLookAt = cameraLookAt;
+        world.spawnBullet(Bullet(tankPosition - vec3(0.f, -4.f, 0.f), gunLookAt));
+        gunCDTimer = 0.f;
+      }
+      gunCDTimer += simDt;
+    }
+    const float simMs = static_cast<float>((glfwGetTime() - simStart) * 1000.0);
+
+    // consumers of this frame's sim events
+    for (const SimEvent& e : world.frameEvents()) {
+      switch (e.type) {
+        case SimEvent::PLANE_SPAWNED: drawPlanes.insert(e.plane.index); break;
+        case SimEvent::PLANE_HIT:     ++score; drawPlanes.erase(e.plane.index); break;
+        case SimEvent::PLANE_EXPIRED: drawPlanes.erase(e.plane.index); break;
+        default: break;
+      }
+    }
+    world.clearFrameEvents();
+
+    // render between the last two sim states
+    const float simAlpha = simClock.alpha();
+    // a parked tank is drawn exactly where it stands, so it can stay in the static shadow cache
+    const bool tankParked = prevTankPosition == tankPosition && prevTankYaw == tankYaw;
+    const float renderTankYaw = tankParked ? tankYaw : glm::mix(prevTankYaw, tankYaw, simAlpha);
+    const vec3 renderTankPosition = tankParked ? tankPosition : glm::mix(prevTankPosition, tankPosition, simAlpha);
+    tankLookAt = glm::vec3(std::sin(renderTankYaw), 0.0f, -std::cos(renderTankYaw));
+    cameraPosition = renderTankPosition - vec3(0.f, -4.f, 0.f);
+
+    // plane instances (model matrix + propeller phase), shared by all three passes
+    const float propPhase = radians(propSpinDeg * 50.f);
+    auto buildPlaneModels = [&](size_t lo, size_t hi) {
+      for (size_t k = lo; k < hi; ++k)
+        planeModels[k] = utils::BuildPlaneBaseModel(planes, drawPlanes[k], simAlpha);
+    };
+    jobs.parallelFor(0, drawPlanes.size(), 64, buildPlaneModels, planeModelsDone);
+
+
+    // the floodlight rides on the camera
+    const vec3 camLightPosition = cameraPosition + vec3(0.f, 2.f, 0.f);
+    mat4 camLightProjView = camLightProj * lookAt(camLightPosition, camLightPosition + cameraLookAt, cameraUp);
 
     
     
 
-    utils::SetUniformMat4(shaderScene, "light_proj_view_matrix", lightProjView);
-    utils::SetUniformMat4(shaderScene, "camLight_proj_view_matrix", camLightProjView);
-    utils::SetUniform1f(shaderScene, "light_near_plane", lightNearPlane);
-    utils::SetUniform1f(shaderScene, "light_far_plane",  lightFarPlane);
-    utils::SetUniformVec3(shaderScene, "light_position",  lightPosition);
-    utils::SetUniformVec3(shaderScene, "light_direction", lightDirection);
-
-    
-    for (auto& p : planes) p.update(dt);
-    for (auto& b : bullets) b.update(dt);
-
-    
     viewMatrix = lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
-    utils::SetUniformMat4(shaderScene, "view_matrix", viewMatrix);
-    utils::SetUniformVec3(shaderScene, "view_position", cameraPosition);
-
-    // SHADOW PASS!!!
-    glUseProgram(shaderShadow);
-    glViewport(0, 0, depth.size, depth.size);
-    glBindFramebuffer(GL_FRAMEBUFFER, depth.fbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_POLYGON_OFFSET_FILL);
-    
-    // glUniform2f(glGetUniformLocation(shaderScene, "uv_scale"), 15.0f, 15.0f);
-    utils::DrawFloorShadowOnly(floorMesh, shaderShadow, lightProjView);
-    
-    utils::DrawCubeShadowOnly(cubeMesh,shaderShadow, lightProjView);
-    
-    
-    utils::DrawTankShadowOnly(tankPosition, tankLookAt, tankMesh, shaderShadow, lightProjView);
-    glUniform2f(glGetUniformLocation(shaderScene, "uv_scale"), 1.f, 1.f);
-
-
 
-    for (const auto& p : planes) {
-      if (!p.isAlive()) continue;
-      utils::DrawPlaneShadowOnly(p, meshes, shaderShadow, lightProjView, propSpinDeg);
+    // refit the sun's cascades that are due; the rest keep the matrix their layer was drawn with
+    bool cascadeDue[SUN_CASCADE_COUNT];
+    for (int c = 0; c < SUN_CASCADE_COUNT; ++c) {
+      cascadeDue[c] = frameIndex == 0 || SunCascades::Due(c, frameIndex);
+      if (cascadeDue[c])
+        frameUniforms.sunCascades[c] = sunCascades.fit(c, cameraPosition, cameraLookAt, cameraFovY, cameraAspect);
     }
-      for (auto& b : bullets) {
-        if (!b.isAlive()) continue;
-        // utils::DrawBulletShadowOnly(b, bulletMesh, shaderShadow, lightProjView);
-        for (auto& p : planes) {
-          if (!p.isAlive()) continue;
-          else if (glm::distance(b.position(), p.position()) < 3.f){
-            b.kill();p.kill();
-          }
-        }
+    ++frameIndex;
+
+    // everything the passes share, one upload per block
+    frameUniforms.view = viewMatrix;
+    frameUniforms.camLightProjView = camLightProjView;
+    frameUniforms.viewPosition = vec4(cameraPosition, 1.f);
+    frameBuffer.update(frameUniforms);
+
+    lightUniforms.floodlight.position = cameraPosition;
+    lightUniforms.floodlight.direction = glm::normalize(cameraLookAt);
+    lightUniforms.floodlight.intensity = floodLightOn ? 6.0f : 0.0f;
+    lightBuffer.update(lightUniforms);
+
+    // what each pass can see; items outside a pass's frustum are dropped from it
+    const Frustum cameraFrustum = Frustum::FromMatrix(projectionMatrix * viewMatrix);
+    const Frustum floodlightFrustum = Frustum::FromMatrix(camLightProjView);
+
+    // everything drawn this frame; each pass below draws its share, sorted by state
+    int spriteCount = 0;
+    for (size_t i = 0; i < bullets.size(); ++i) {
+      if (!bullets.isAlive(i)) continue;
+      const vec3 p = bullets.interpolatedPosition(i, simAlpha);
+      if (cameraFrustum.intersectsSphere(p, BULLET_SIZE)) bulletSprites[spriteCount++] = p;
+    }
+    utils::UploadSprites(bulletSpriteBuffer, bulletSprites.data(), spriteCount);
+
+    const GLuint sceneProgram = floodLightOn ? shaderScene : shaderSceneSun;
+    renderQueue.clear();
+    renderQueue.submit(utils::MeshItem(cubeMesh, utils::BuildCubeModel(), sceneProgram, PASS_ALL_STATIC, vec2(15.0f)));
+    renderQueue.submit(utils::MeshItem(floorMesh, utils::BuildFloorBaseModel(), sceneProgram, PASS_ALL_STATIC, vec2(15.0f)));
+    renderQueue.submit(utils::MeshItem(tankMesh, utils::BuildTankModel(renderTankPosition, tankLookAt), sceneProgram,
+                                       tankParked ? PASS_ALL_STATIC : PASS_ALL));
+    renderQueue.submit(utils::SpriteItem(bulletSpriteBuffer, shaderBullet));
+    jobs.wait(planeModelsDone);
+    for (size_t k = 0; k < drawPlanes.size(); ++k)
+      utils::SubmitPlane(renderQueue, planeModels[k], meshes, sceneProgram, propPhase);
+    uint32_t culledItems = renderQueue.cull(PASS_SCENE, cameraFrustum);
+    // the floodlight's map is only redrawn while the light is on, and then
+    // only when the light has moved or a caster inside its frustum changed
+    bool drawFloodlightShadow = false;
+    if (floodLightOn) {
+      const uint64_t key = renderQueue.signature(PASS_SPOT_SHADOW, camLightProjView);
+      drawFloodlightShadow = key != floodlightShadowKey;
+      floodlightShadowKey = key;
     }
-    // (SHADOW PASS 2)
-    glViewport(0, 0, depthCam.size, depthCam.size);
-    glBindFramebuffer(GL_FRAMEBUFFER, depthCam.fbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
 
-    utils::DrawFloorShadowOnly(floorMesh, shaderShadow, camLightProjView);
-    
-    utils::DrawTankShadowOnly(tankPosition, tankLookAt, tankMesh, shaderShadow, camLightProjView);
-    utils::DrawCubeShadowOnly(cubeMesh,shaderShadow, camLightProjView);
-    for (const auto& p : planes) if (p.isAlive()) utils::DrawPlaneShadowOnly(p, meshes, shaderShadow, camLightProjView, propSpinDeg);
+    // SHADOW PASS!!! every due cascade in one layered pass, each item sent
+    // only to the cascades whose frustum it reaches
+    Frustum cascadeFrustums[SUN_CASCADE_COUNT];
+    uint32_t dueLayers = 0, bakeLayers = 0;
+    for (int c = 0; c < SUN_CASCADE_COUNT; ++c) {
+      cascadeFrustums[c] = Frustum::FromMatrix(frameUniforms.sunCascades[c]);
+      if (!cascadeDue[c]) continue;
+      dueLayers |= 1u << c;
+      // static casters are redrawn into their cache only when one of them or the cascade changed
+      const uint64_t staticKey = renderQueue.signature(PASS_SUN_STATIC, frameUniforms.sunCascades[c]);
+      if (staticKey != staticShadowKeys[c]) bakeLayers |= 1u << c;
+      staticShadowKeys[c] = staticKey;
+    }
+    utils::UseProgram(shaderShadowLayered);
+    utils::SetShadowLayers(shaderShadowLayered, frameUniforms.sunCascades, SUN_CASCADE_COUNT);
+    GLState::Viewport(0, 0, sunCascadeMaps.size, sunCascadeMaps.size);
+    GLState::SetCapability(GL_POLYGON_OFFSET_FILL, true);
+    if (bakeLayers) {
+      for (int c = 0; c < SUN_CASCADE_COUNT; ++c) {
+        if (!(bakeLayers & (1u << c))) continue;
+        GLState::BindFramebuffer(sunStaticMaps.fbos[c]);
+        glClear(GL_DEPTH_BUFFER_BIT);
+      }
+      GLState::BindFramebuffer(sunStaticMaps.layeredFbo);
+      culledItems += renderQueue.flushLayers(PASS_SUN_STATIC, shaderShadowLayered, cascadeFrustums,
+                                             SUN_CASCADE_COUNT, bakeLayers);
+    }
+    // start from the static casters, then add the moving ones
+    for (int c = 0; c < SUN_CASCADE_COUNT; ++c)
+      if (cascadeDue[c]) utils::CopyDepthMap(utils::Layer(sunStaticMaps, c), utils::Layer(sunCascadeMaps, c));
+    GLState::BindFramebuffer(sunCascadeMaps.layeredFbo);
+    culledItems += renderQueue.flushLayers(PASS_SUN_SHADOW, shaderShadowLayered, cascadeFrustums,
+                                           SUN_CASCADE_COUNT, dueLayers);
+
+    // (SHADOW PASS 2) the spotlights' layers, the same way
+    if (drawFloodlightShadow) {
+      utils::SetShadowLayers(shaderShadowLayered, &camLightProjView, 1);
+      GLState::Viewport(0, 0, spotShadowMaps.size, spotShadowMaps.size);
+      GLState::BindFramebuffer(spotShadowMaps.fbos[FLOODLIGHT_LAYER]);
+      glClear(GL_DEPTH_BUFFER_BIT);
+      GLState::BindFramebuffer(spotShadowMaps.layeredFbo);
+      culledItems += renderQueue.flushLayers(PASS_SPOT_SHADOW, shaderShadowLayered, &floodlightFrustum, 1,
+                                             1u << FLOODLIGHT_LAYER);
+    }
 
-    
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
     // SCENE PASS!!!
-    glUseProgram(shaderScene);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);\
+    utils::UseProgram(sceneProgram);
+    GLState::BindFramebuffer(0);
+    GLState::SetCapability(GL_POLYGON_OFFSET_FILL, false);
     int fbw, fbh;
     glfwGetFramebufferSize(window, &fbw, &fbh);
-    glViewport(0, 0, fbw, fbh);
+    GLState::Viewport(0, 0, fbw, fbh);
     glClearColor(0.2f, 0.35f, 0.7f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    utils::BindShadowMap(depth.texture, depthCam.texture); //binds to tex unit 1,2 by default
-    glm::vec3 camPos = cameraPosition;
-    glm::vec3 camDir = glm::normalize(cameraLookAt);
+    utils::BindShadowMap(sunCascadeMaps.texture, spotShadowMaps.texture); //binds to tex unit 1,2 by default
     vec3 cameraSideVector = normalize(glm::cross(cameraLookAt, vec3(0,1,0)));
-    if (floodLightOn){
-
-      utils::SetUniformVec3(shaderScene, "camLight_position",   camPos);
-      utils::SetUniformVec3(shaderScene, "camLight_direction",  camDir);
-      utils::SetUniformVec3(shaderScene, "camLight_color",      glm::vec3(1.0f, 1.0f, 0.6f));
-      utils::SetUniform1f (shaderScene, "camLight_intensity",   6.0f);
-      utils::SetUniform1f (shaderScene, "camLight_cutoff_inner", cos(glm::radians(10.0f)));
-      utils::SetUniform1f (shaderScene, "camLight_cutoff_outer", cos(glm::radians(14.0f)));
-      // 
-    }
-    else {utils::SetUniform1f (shaderScene, "camLight_intensity",   0.0f);}
-
 
-    
-    glUniform2f(glGetUniformLocation(shaderScene, "uv_scale"), 15.0f, 15.0f);
-    utils::DrawCubeSceneOnly(cubeMesh, shaderScene);
 
-    utils::DrawFloorSceneOnly(floorMesh, shaderScene);
-    
-    glUniform2f(glGetUniformLocation(shaderScene, "uv_scale"), 1.0f, 1.0f);
-    utils::DrawTankSceneOnly(tankPosition, tankLookAt, tankMesh, shaderScene);
+    utils::SetUniform1f(shaderBullet, "viewport_height", static_cast<float>(fbh));
+    renderQueue.flush(PASS_SCENE);
     
-   
-    for (const auto& p : planes) {
-      if (!p.isAlive()) continue;
-      utils::DrawPlaneSceneOnly(p, meshes, shaderScene, propSpinDeg);
-    }
-    for (const auto& b : bullets) {
-      if (!b.isAlive()) continue;
-      utils::DrawBulletSceneOnly(b, bulletMesh, shaderScene);
+    // CPU time of the frame, taken before the swap so vsync waits don't count
+    governor.observe(static_cast<float>((glfwGetTime() - frameStart) * 1000.0), simMs, dt);
+    statsTimer += dt;
+    if (statsTimer > 1.f) {
+      const BudgetCounters& c = governor.counters();
+      std::ostringstream title;
+      title << "score " << score << "  planes " << planes.liveCount() << "/" << governor.planeCap()
+            << "  bullets " << bullets.size() << "/" << governor.bulletCap()
+            << "  wave " << governor.spawnInterval() << "s"
+            << "  frame " << governor.smoothedFrameMs() << "/" << governor.targetFrameMs() << "ms"
+            << "  sim " << governor.smoothedSimMs() << "ms"
+            << "  cuts " << c.cuts << " raises " << c.raises
+            << " deferred " << c.planesDeferred << " refused " << c.bulletsRefused
+            << "  culled " << culledItems
+            << "  gl state " << GLState::LastFrame().issued << " set/" << GLState::LastFrame().filtered << " skipped";
+      glfwSetWindowTitle(window, title.str().c_str());
+      statsTimer = 0.f;
     }
-    
+
     glfwSwapBuffers(window);
     glfwPollEvents();
 
@@ -286,23 +468,8 @@ int main(int argc, char* argv[]) {
     cameraLookAt = computeCameraLookAt(lastMousePosX, lastMousePosY, dt);
     
 
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) tankYaw += TANK_TURN_SPEED * dt;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) tankYaw -= TANK_TURN_SPEED * dt;
-    glm::vec3 tankForward = glm::vec3(std::sin(tankYaw), 0.0f, -std::cos(tankYaw));
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) tankPosition += tankForward * (TANK_SPEED * dt);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) tankPosition -= tankForward * (TANK_SPEED * dt);
     if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) floodLightOn = true;
     if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) floodLightOn = false;
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && gunCDTimer > 0.2f) {
-      vec3 gunLookAt = cameraLookAt;
-      bullets.emplace_back(cameraPosition, gunLookAt);
-      gunCDTimer = 0.f;
-    }
-    gunCDTimer += dt;
-
-    tankLookAt = glm::normalize(tankForward);
-    cameraPosition = tankPosition - vec3(0.f, -4.f, 0.f);
     // cout<<cameraLookAt[0]<<","<<cameraLookAt[1]<<","<<cameraLookAt[2]<<"\n";
     
 
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// What the governor has done so far; read these for overlays and logs.
+struct BudgetCounters {
+    std::uint64_t frames = 0;
+    std::uint64_t framesOverBudget = 0;   // smoothed frame time above target
+    std::uint64_t cuts = 0;               // times the caps were cut
+    std::uint64_t raises = 0;             // times the caps were raised
+    std::uint64_t planesDeferred = 0;     // spawns skipped by the plane cap
+    std::uint64_t bulletsRefused = 0;     // shots dropped by the bullet cap
+};
+
+struct BudgetLimits {
+    std::uint32_t minPlanes = 8, maxPlanes = 256;
+    std::size_t minBullets = 64, maxBullets = 1024;
+    float minSpawnInterval = 0.5f, maxSpawnInterval = 4.f;   // seconds between plane waves
+};
+
+// Population controller that holds a frame-time budget. observe() takes the
+// CPU time of each frame (before the buffer swap, so vsync waits don't look
+// like load) and the part of it spent in the simulation. Both are smoothed;
+// when the frame runs over budget the plane and bullet caps are cut by a
+// fraction and waves slow down, with some headroom they grow back a little
+// at a time. Bullets are cut harder when the sim is the larger share.
+// Changes are rate-limited so the smoothing lag can't make it oscillate.
+class BudgetGovernor {
+private:
+    static constexpr float SMOOTHING = 0.1f;          // EMA weight of a new sample
+    static constexpr float OVER = 1.05f;              // cut above target * OVER
+    static constexpr float UNDER = 0.8f;              // grow below target * UNDER
+    static constexpr float ADJUST_INTERVAL = 0.25f;   // seconds between changes
+    static constexpr float CUT = 0.85f;
+    static constexpr std::uint32_t PLANE_STEP = 2;
+    static constexpr std::size_t BULLET_STEP = 16;
+    // non-positive budgets would count every frame as over and pin the caps
+    // to their minimums, so they fall back to this
+    static constexpr float MIN_TARGET_MS = 1.f;
+
+    BudgetLimits limits;
+    float targetMs;
+    float frameMs{0.f}, simMs{0.f};   // smoothed
+    float sinceAdjust{0.f};
+    std::uint32_t planeLimit;
+    std::size_t bulletLimit;
+    float interval;
+    BudgetCounters stats;
+
+public:
+    explicit BudgetGovernor(float targetFrameMs, const BudgetLimits& l = BudgetLimits())
+        : limits(l), targetMs(targetFrameMs > 0.f ? targetFrameMs : MIN_TARGET_MS),
+          planeLimit(std::clamp<std::uint32_t>(32, l.minPlanes, l.maxPlanes)),
+          bulletLimit(l.maxBullets), interval(l.maxSpawnInterval) {}
+
+    // once per frame, times in milliseconds; dt is the frame's wall time in seconds
+    void observe(float frameWorkMs, float simWorkMs, float dt) {
+        if (stats.frames++ == 0) { frameMs = frameWorkMs; simMs = simWorkMs; }
+        frameMs += SMOOTHING * (frameWorkMs - frameMs);
+        simMs += SMOOTHING * (simWorkMs - simMs);
+        if (frameMs > targetMs * OVER) ++stats.framesOverBudget;
+
+        sinceAdjust += dt;
+        if (sinceAdjust < ADJUST_INTERVAL) return;
+
+        if (frameMs > targetMs * OVER) {
+            const float simShare = frameMs > 0.f ? simMs / frameMs : 0.f;
+            planeLimit = std::max(limits.minPlanes, static_cast<std::uint32_t>(planeLimit * CUT));
+            bulletLimit = std::max(limits.minBullets, static_cast<std::size_t>(bulletLimit * (simShare > 0.5f ? CUT * CUT : CUT)));
+            interval = std::min(limits.maxSpawnInterval, interval / CUT);
+            ++stats.cuts;
+            sinceAdjust = 0.f;
+        } else if (frameMs < targetMs * UNDER) {
+            if (planeLimit < limits.maxPlanes || bulletLimit < limits.maxBullets || interval > limits.minSpawnInterval) {
+                planeLimit = std::min(limits.maxPlanes, planeLimit + PLANE_STEP);
+                bulletLimit = std::min(limits.maxBullets, bulletLimit + BULLET_STEP);
+                interval = std::max(limits.minSpawnInterval, interval * 0.95f);
+                ++stats.raises;
+            }
+            sinceAdjust = 0.f;
+        }
+    }
+
+    // call before spawning; counts the spawn as deferred when it says no
+    bool allowPlane(std::size_t livePlanes) {
+        if (livePlanes < planeLimit) return true;
+        ++stats.planesDeferred;
+        return false;
+    }
+    bool allowBullet(std::size_t liveBullets) {
+        if (liveBullets < bulletLimit) return true;
+        ++stats.bulletsRefused;
+        return false;
+    }
+
+    std::uint32_t planeCap() const { return planeLimit; }
+    std::size_t bulletCap() const { return bulletLimit; }
+    float spawnInterval() const { return interval; }
+    float smoothedFrameMs() const { return frameMs; }
+    float smoothedSimMs() const { return simMs; }
+    float targetFrameMs() const { return targetMs; }
+    const BudgetCounters& counters() const { return stats; }
+};
@@ -2,16 +2,12 @@
 #include <algorithm>
 #include <iostream>
 #include <vector>
-#include <random>
-
-
-#define GLEW_STATIC 1
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "SimRandom.h"
+
 constexpr float SPEED      = 80.f;  // unit/s
 constexpr float LIFESPAN_      = 5.f;
 constexpr glm::vec3 GRAV = glm::vec3(0.f, -6.f, 0.f);
@@ -19,39 +15,25 @@ constexpr glm::vec3 GRAV = glm::vec3(0.f, -6.f, 0.f);
 
 
 
+// spawn description of a single shot; integration lives in BulletPool
 class Bullet {
 private:
-    bool alive{true};
     glm::vec3 pos{};
     glm::vec3 vel{};
-    float age{0.f};
 
 public:
-    explicit Bullet(const glm::vec3& startPos, const glm::vec3& gunLookAt)
-        : pos(startPos)
+    // spread: per-axis jitter added to the muzzle velocity, each -1, 0 or 1
+    Bullet(const glm::vec3& startPos, const glm::vec3& gunLookAt, const glm::vec3& spread)
+        : pos(startPos), vel(SPEED * gunLookAt + spread)
     {
-        vel = SPEED * gunLookAt
-            + glm::vec3(1.f * randomPick(), 1.f * randomPick(), 1.f * randomPick());
     }
 
-    void update(float dt) {
-        if (this->alive){
-            pos += vel * dt;
-            pos += GRAV * dt;
-            age += dt;
-            if (this->age > LIFESPAN_){
-                alive = false;
-                return;
-            }
-
-        }  
-    }
-    void kill(){
-        this->alive = false;
+    explicit Bullet(const glm::vec3& startPos, const glm::vec3& gunLookAt)
+        : Bullet(startPos, gunLookAt, glm::vec3(randomPick(), randomPick(), randomPick()))
+    {
     }
 
     glm::vec3 position() const { return pos; }
     glm::vec3 velocity() const { return vel; }
-    bool isAlive() const { return alive; }
     
 };
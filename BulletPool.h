@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bullet.h"
+#include "EventQueue.h"
+#include "StaticWorld.h"
+
+// Structure-of-arrays bullet storage. Live bullets are kept packed at the
+// front: dead entries are removed by swapping with the last one, so the
+// per-frame loops only ever walk bullets that can still hit or be drawn.
+// Capacity is fixed at construction; spawning never allocates.
+class BulletPool {
+private:
+    std::size_t cap;
+    std::vector<glm::vec3> pos;
+    std::vector<glm::vec3> prevPos;   // position at the start of the last step
+    std::vector<glm::vec3> vel;
+    std::vector<float> age;
+    std::vector<std::uint8_t> alive;
+    std::vector<std::uint32_t> ids;
+    std::uint32_t nextId = 0;
+
+    void swapRemove(std::size_t i) {
+        const std::size_t last = pos.size() - 1;
+        if (i != last) {
+            pos[i]   = pos[last];
+            prevPos[i] = prevPos[last];
+            vel[i]   = vel[last];
+            age[i]   = age[last];
+            alive[i] = alive[last];
+            ids[i]   = ids[last];
+        }
+        pos.pop_back();
+        prevPos.pop_back();
+        vel.pop_back();
+        age.pop_back();
+        alive.pop_back();
+        ids.pop_back();
+    }
+
+public:
+    explicit BulletPool(std::size_t capacity)
+        : cap(capacity)
+    {
+        pos.reserve(capacity);
+        prevPos.reserve(capacity);
+        vel.reserve(capacity);
+        age.reserve(capacity);
+        alive.reserve(capacity);
+        ids.reserve(capacity);
+    }
+
+    // drops the shot and returns false when the pool is full
+    bool spawn(const Bullet& b) {
+        if (pos.size() == cap) return false;
+        pos.push_back(b.position());
+        prevPos.push_back(b.position());
+        vel.push_back(b.velocity());
+        age.push_back(0.f);
+        alive.push_back(1);
+        ids.push_back(nextId++);
+        return true;
+    }
+
+    // integrates every bullet, expires old ones and compacts the arrays
+    void updateAll(float dt) {
+        integrateRange(dt, 0, pos.size());
+        removeDead();
+    }
+
+    // integration only; disjoint ranges may run on different threads, then
+    // removeDead() once. Expiries are reported to events when given.
+    void integrateRange(float dt, std::size_t lo, std::size_t hi, EventQueue* events = nullptr) {
+        const glm::vec3 gravStep = GRAV * dt;
+        for (std::size_t i = lo; i < hi; ++i) {
+            prevPos[i] = pos[i];
+            pos[i] += vel[i] * dt;
+            pos[i] += gravStep;
+            age[i] += dt;
+            if (age[i] > LIFESPAN_ && alive[i]) {
+                alive[i] = 0;
+                if (events) events->push(SimEvent{ SimEvent::BULLET_EXPIRED, EntityHandle{}, ids[i], pos[i] });
+            }
+        }
+    }
+
+    // flags bullets whose last step ran into static scenery; same threading
+    // rules as integrateRange, call it after integrating the range
+    void collideWithWorld(const StaticWorld& world, std::size_t lo, std::size_t hi, EventQueue* events = nullptr) {
+        if (lo >= hi) return;
+        world.cullSegments(prevPos.data() + lo, pos.data() + lo, alive.data() + lo, hi - lo,
+                           [&](std::size_t k, float toi) {
+                               const std::size_t i = lo + k;
+                               if (events) events->push(SimEvent{ SimEvent::BULLET_HIT_WORLD, EntityHandle{},
+                                                                  ids[i], glm::mix(prevPos[i], pos[i], toi) });
+                           });
+    }
+
+    // swap-remove every entry flagged dead; order of live bullets is not kept
+    void removeDead() {
+        std::size_t i = 0;
+        while (i < pos.size()) {
+            if (alive[i]) ++i;
+            else swapRemove(i);
+        }
+    }
+
+    // marks only; indices stay valid until the next updateAll/removeDead
+    void kill(std::size_t i) { alive[i] = 0; }
+
+    std::size_t size() const { return pos.size(); }
+    std::size_t capacity() const { return cap; }
+    bool empty() const { return pos.empty(); }
+    const glm::vec3& position(std::size_t i) const { return pos[i]; }
+    const glm::vec3& previousPosition(std::size_t i) const { return prevPos[i]; }
+    // alpha in [0, 1] between the last two sim states
+    glm::vec3 interpolatedPosition(std::size_t i, float alpha) const { return glm::mix(prevPos[i], pos[i], alpha); }
+    const glm::vec3& velocity(std::size_t i) const { return vel[i]; }
+    bool isAlive(std::size_t i) const { return alive[i] != 0; }
+    // stays with the bullet while swap-removes move it; counts up per spawn
+    std::uint32_t id(std::size_t i) const { return ids[i]; }
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AirplaneFleet.h"
+#include "BulletPool.h"
+#include "EventQueue.h"
+
+constexpr float HIT_RADIUS = 3.f;   // bullet-to-plane distance that counts as a hit
+
+struct HitPair {
+    std::uint32_t bullet;   // BulletPool index, valid until the next updateAll
+    std::uint32_t plane;    // AirplaneFleet slot
+    float toi;              // fraction of the last step at first contact
+};
+
+// Earliest t in [0, 1] at which two points moving linearly from a0->a1 and
+// b0->b1 come within radius of each other. Returns false if they never do.
+inline bool SweptSphereToi(const glm::vec3& a0, const glm::vec3& a1,
+                           const glm::vec3& b0, const glm::vec3& b1,
+                           float radius, float& toi)
+{
+    const glm::vec3 r0 = a0 - b0;
+    const glm::vec3 v  = (a1 - a0) - (b1 - b0);
+    const float c = glm::dot(r0, r0) - radius * radius;
+    if (c < 0.f) { toi = 0.f; return true; }      // already touching at the start
+    const float a = glm::dot(v, v);
+    const float b = glm::dot(r0, v);
+    if (b >= 0.f || a < 1e-12f) return false;    // moving apart or not moving
+    const float disc = b * b - a * c;
+    if (disc < 0.f) return false;
+    const float t = (-b - std::sqrt(disc)) / a;
+    if (t > 1.f) return false;
+    toi = t;
+    return true;
+}
+
+// Spatial hash over plane positions, rebuilt every frame with a counting
+// sort. Cells are HIT_RADIUS wide; a bullet queries the cells covering its
+// swept segment, grown by the hit radius plus the furthest any plane moved
+// this step. Each plane keeps only its earliest hit. All storage is sized
+// from the fleet capacity up front.
+// build() is serial; sweepBullet() may be called from several threads.
+class PlaneGrid {
+private:
+    float cellSize;
+    float invCellSize;
+    std::uint32_t mask;                      // table size - 1 (power of two)
+    std::vector<std::uint32_t> bucketStart;  // prefix sums, table size + 1
+    std::vector<std::uint32_t> cursor;       // scratch: fill position per bucket
+    std::vector<std::uint32_t> entries;      // plane slots grouped by bucket
+    std::vector<glm::vec3> entryPos;         // positions in the same order
+    std::vector<glm::vec3> entryPrev;        // start-of-step positions, same order
+    std::vector<std::uint32_t> planeBucket;  // scratch: bucket of each plane
+    // scratch: earliest hit per plane packed as (toi bits << 32 | bullet) so
+    // an atomic min keeps the earliest contact, lowest bullet on ties
+    std::unique_ptr<std::atomic<std::uint64_t>[]> planeHit;
+    std::size_t planeRange{0};
+    float maxPlaneStep{0.f};
+
+    glm::ivec3 cellOf(const glm::vec3& p) const {
+        return glm::ivec3(static_cast<int>(std::floor(p.x * invCellSize)),
+                          static_cast<int>(std::floor(p.y * invCellSize)),
+                          static_cast<int>(std::floor(p.z * invCellSize)));
+    }
+
+    std::uint32_t bucketOf(const glm::ivec3& c) const {
+        const std::uint32_t h = static_cast<std::uint32_t>(c.x) * 73856093u
+                              ^ static_cast<std::uint32_t>(c.y) * 19349663u
+                              ^ static_cast<std::uint32_t>(c.z) * 83492791u;
+        return h & mask;
+    }
+
+public:
+    PlaneGrid(std::size_t planeCapacity, float cell = HIT_RADIUS)
+        : cellSize(cell), invCellSize(1.f / cell)
+    {
+        std::uint32_t tableSize = 64;
+        while (tableSize < 2 * planeCapacity) tableSize <<= 1;
+        mask = tableSize - 1;
+        bucketStart.assign(tableSize + 1, 0);
+        cursor.resize(tableSize);
+        entries.resize(planeCapacity);
+        entryPos.resize(planeCapacity);
+        entryPrev.resize(planeCapacity);
+        planeBucket.resize(planeCapacity);
+        planeHit.reset(new std::atomic<std::uint64_t>[planeCapacity]);
+    }
+
+    void build(const AirplaneFleet& planes) {
+        std::fill(bucketStart.begin(), bucketStart.end(), 0u);
+        const std::size_t n = planes.size();
+        planeRange = n;
+        maxPlaneStep = 0.f;
+        for (std::size_t p = 0; p < n; ++p) {
+            planeHit[p].store(NO_HIT, std::memory_order_relaxed);
+            if (!planes.isAlive(p)) continue;
+            maxPlaneStep = std::max(maxPlaneStep, glm::length(planes.position(p) - planes.previousPosition(p)));
+            planeBucket[p] = bucketOf(cellOf(planes.position(p)));
+            ++bucketStart[planeBucket[p] + 1];
+        }
+        for (std::size_t b = 1; b < bucketStart.size(); ++b) bucketStart[b] += bucketStart[b - 1];
+
+        std::copy(bucketStart.begin(), bucketStart.end() - 1, cursor.begin());
+        for (std::size_t p = 0; p < n; ++p) {
+            if (!planes.isAlive(p)) continue;
+            const std::uint32_t slot = cursor[planeBucket[p]]++;
+            entries[slot] = static_cast<std::uint32_t>(p);
+            entryPos[slot] = planes.position(p);
+            entryPrev[slot] = planes.previousPosition(p);
+        }
+    }
+
+    // tests one bullet moving b0 -> b1 this step against nearby planes
+    void sweepBullet(std::uint32_t bullet, const glm::vec3& b0, const glm::vec3& b1, float radius) {
+        const glm::vec3 reach(radius + maxPlaneStep);
+        const glm::ivec3 lo = cellOf(glm::min(b0, b1) - reach);
+        const glm::ivec3 hi = cellOf(glm::max(b0, b1) + reach);
+        const std::size_t cells = std::size_t(hi.x - lo.x + 1) * std::size_t(hi.y - lo.y + 1) * std::size_t(hi.z - lo.z + 1);
+
+        // very long sweeps (e.g. a frame hitch) cover more cells than buckets
+        if (cells > mask + 1) {
+            testEntries(bullet, b0, b1, radius, 0, bucketStart.back());
+            return;
+        }
+        for (int z = lo.z; z <= hi.z; ++z)
+        for (int y = lo.y; y <= hi.y; ++y)
+        for (int x = lo.x; x <= hi.x; ++x) {
+            const std::uint32_t b = bucketOf(glm::ivec3(x, y, z));
+            testEntries(bullet, b0, b1, radius, bucketStart[b], bucketStart[b + 1]);
+        }
+    }
+
+    // one HitPair per plane that was hit, carrying its earliest contact
+    void collectHits(std::vector<HitPair>& hits) const {
+        for (std::size_t p = 0; p < planeRange; ++p) {
+            const std::uint64_t packed = planeHit[p].load(std::memory_order_relaxed);
+            if (packed == NO_HIT) continue;
+            const std::uint32_t toiBits = static_cast<std::uint32_t>(packed >> 32);
+            float toi;
+            std::memcpy(&toi, &toiBits, sizeof(toi));
+            hits.push_back(HitPair{ static_cast<std::uint32_t>(packed), static_cast<std::uint32_t>(p), toi });
+        }
+    }
+
+    // same as collectHits, as PLANE_HIT events for planes in [lo, hi) that
+    // name the bullet by its BulletPool::id; disjoint ranges may be emitted
+    // from different threads
+    void emitHits(const AirplaneFleet& planes, const BulletPool& bullets, EventQueue& events,
+                  std::size_t lo, std::size_t hi) const {
+        hi = std::min(hi, planeRange);
+        for (std::size_t p = lo; p < hi; ++p) {
+            const std::uint64_t packed = planeHit[p].load(std::memory_order_relaxed);
+            if (packed == NO_HIT) continue;
+            events.push(SimEvent{ SimEvent::PLANE_HIT, planes.handleAt(p), bullets.id(static_cast<std::uint32_t>(packed)),
+                                  planes.position(p) });
+        }
+    }
+
+    float cell() const { return cellSize; }
+
+private:
+    static constexpr std::uint64_t NO_HIT = ~std::uint64_t(0);
+
+    void testEntries(std::uint32_t bullet, const glm::vec3& b0, const glm::vec3& b1,
+                     float radius, std::uint32_t first, std::uint32_t last) {
+        for (std::uint32_t e = first; e < last; ++e) {
+            float toi;
+            if (!SweptSphereToi(b0, b1, entryPrev[e], entryPos[e], radius, toi)) continue;
+            // toi is in [0, 1], where float bit patterns order like the values
+            std::uint32_t toiBits;
+            std::memcpy(&toiBits, &toi, sizeof(toi));
+            const std::uint64_t packed = (std::uint64_t(toiBits) << 32) | bullet;
+            std::atomic<std::uint64_t>& slot = planeHit[entries[e]];
+            std::uint64_t seen = slot.load(std::memory_order_relaxed);
+            while (packed < seen && !slot.compare_exchange_weak(seen, packed, std::memory_order_relaxed)) {}
+        }
+    }
+};
+
+// Collision phase: rebuilds the grid and sweeps every live bullet over its
+// last step, so hits do not depend on the step size. Each hit plane is
+// credited to the bullet that reached it first; a bullet can still take out
+// several planes. Nothing is killed here, the caller applies the hits.
+inline void SweepBulletRange(const BulletPool& bullets, PlaneGrid& grid, std::size_t lo, std::size_t hi)
+{
+    for (std::size_t i = lo; i < hi; ++i) {
+        if (!bullets.isAlive(i)) continue;
+        grid.sweepBullet(static_cast<std::uint32_t>(i), bullets.previousPosition(i),
+                         bullets.position(i), HIT_RADIUS);
+    }
+}
+
+inline void CollideBulletsWithPlanes(const BulletPool& bullets, const AirplaneFleet& planes,
+                                     PlaneGrid& grid, std::vector<HitPair>& hits)
+{
+    hits.clear();
+    grid.build(planes);
+    SweepBulletRange(bullets, grid, 0, bullets.size());
+    grid.collectHits(hits);
+}
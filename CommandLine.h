@@ -0,0 +1,42 @@
+#pragma once
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Checked number parsing for command-line flags. The whole argument has to
+// be one number that fits, otherwise the parse fails and out is left as it
+// was, so callers can print an error instead of dying on an exception.
+
+inline bool ParseFloatArg(const char* text, float& out)
+{
+    char* end = nullptr;
+    errno = 0;
+    const float v = std::strtof(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(v)) return false;
+    out = v;
+    return true;
+}
+
+inline bool ParseIntArg(const char* text, long& out)
+{
+    char* end = nullptr;
+    errno = 0;
+    const long v = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE) return false;
+    out = v;
+    return true;
+}
+
+// digits only: strtoull would otherwise wrap "-1" round to a huge value
+inline bool ParseUnsignedArg(const char* text, std::uint64_t max, std::uint64_t& out)
+{
+    if (!std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long v = std::strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || v > max) return false;
+    out = v;
+    return true;
+}
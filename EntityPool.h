@@ -0,0 +1,145 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Stable reference to a pooled entity. The generation is bumped every time a
+// slot is released, so a handle to a despawned entity never resolves to
+// whatever reuses its slot later.
+struct EntityHandle {
+    static constexpr std::uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    std::uint32_t index{INVALID_INDEX};
+    std::uint32_t generation{0};
+
+    bool valid() const { return index != INVALID_INDEX; }
+    bool operator==(const EntityHandle& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const EntityHandle& o) const { return !(*this == o); }
+};
+
+// Fixed-capacity slot bookkeeping shared by EntityPool and the SoA stores.
+// All memory is reserved up front; acquire/release are O(1) and never allocate.
+class SlotAllocator {
+private:
+    std::vector<std::uint32_t> generations;
+    std::vector<std::uint8_t> used;
+    std::vector<std::uint32_t> freeList;
+    std::uint32_t highWater{0};   // one past the highest slot ever handed out
+
+public:
+    explicit SlotAllocator(std::uint32_t capacity)
+        : generations(capacity, 0), used(capacity, 0)
+    {
+        // lowest indices on top so live slots stay packed near the front
+        freeList.reserve(capacity);
+        for (std::uint32_t i = capacity; i-- > 0;) freeList.push_back(i);
+    }
+
+    // returns an invalid handle when the pool is full
+    EntityHandle acquire() {
+        if (freeList.empty()) return EntityHandle{};
+        const std::uint32_t i = freeList.back();
+        freeList.pop_back();
+        used[i] = 1;
+        if (i + 1 > highWater) highWater = i + 1;
+        return EntityHandle{ i, generations[i] };
+    }
+
+    void release(std::uint32_t i) {
+        if (!used[i]) return;
+        used[i] = 0;
+        ++generations[i];
+        freeList.push_back(i);
+    }
+
+    bool contains(const EntityHandle& h) const {
+        return h.index < used.size() && used[h.index] && generations[h.index] == h.generation;
+    }
+
+    bool isUsed(std::uint32_t i) const { return used[i] != 0; }
+    EntityHandle handleAt(std::uint32_t i) const { return EntityHandle{ i, generations[i] }; }
+    std::uint32_t capacity() const { return static_cast<std::uint32_t>(used.size()); }
+    std::uint32_t liveCount() const { return capacity() - static_cast<std::uint32_t>(freeList.size()); }
+    std::uint32_t slotRange() const { return highWater; }
+};
+
+// Dense set of slot indices with O(1) insert and erase, for walking only the
+// live entries of a slot store; erase moves the last entry into the hole.
+class SlotSet {
+private:
+    static constexpr std::uint32_t ABSENT = 0xFFFFFFFFu;
+    std::vector<std::uint32_t> items;
+    std::vector<std::uint32_t> where;   // slot -> position in items
+
+public:
+    explicit SlotSet(std::uint32_t capacity)
+        : where(capacity, ABSENT)
+    {
+        items.reserve(capacity);
+    }
+
+    void insert(std::uint32_t slot) {
+        if (where[slot] != ABSENT) return;
+        where[slot] = static_cast<std::uint32_t>(items.size());
+        items.push_back(slot);
+    }
+    void erase(std::uint32_t slot) {
+        const std::uint32_t at = where[slot];
+        if (at == ABSENT) return;
+        items[at] = items.back();
+        where[items[at]] = at;
+        items.pop_back();
+        where[slot] = ABSENT;
+    }
+
+    bool contains(std::uint32_t slot) const { return where[slot] != ABSENT; }
+    std::size_t size() const { return items.size(); }
+    std::uint32_t operator[](std::size_t i) const { return items[i]; }
+    std::vector<std::uint32_t>::const_iterator begin() const { return items.begin(); }
+    std::vector<std::uint32_t>::const_iterator end() const { return items.end(); }
+};
+
+// Generation-checked pool of T with fixed capacity. Objects are constructed
+// in place; despawn destroys the object and frees its slot for reuse.
+template <typename T>
+class EntityPool {
+private:
+    SlotAllocator slots;
+    std::vector<std::optional<T>> items;
+
+public:
+    explicit EntityPool(std::uint32_t capacity)
+        : slots(capacity), items(capacity) {}
+
+    template <typename... Args>
+    EntityHandle spawn(Args&&... args) {
+        const EntityHandle h = slots.acquire();
+        if (h.valid()) items[h.index].emplace(std::forward<Args>(args)...);
+        return h;
+    }
+
+    void despawn(const EntityHandle& h) {
+        if (!slots.contains(h)) return;
+        items[h.index].reset();
+        slots.release(h.index);
+    }
+
+    T* get(const EntityHandle& h) {
+        return slots.contains(h) ? &*items[h.index] : nullptr;
+    }
+    const T* get(const EntityHandle& h) const {
+        return slots.contains(h) ? &*items[h.index] : nullptr;
+    }
+
+    // f(handle, object); despawning the visited entity from inside f is fine
+    template <typename F>
+    void forEach(F&& f) {
+        for (std::uint32_t i = 0; i < slots.slotRange(); ++i)
+            if (items[i]) f(slots.handleAt(i), *items[i]);
+    }
+
+    std::uint32_t size() const { return slots.liveCount(); }
+    std::uint32_t capacity() const { return slots.capacity(); }
+};
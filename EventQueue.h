@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "EntityPool.h"
+
+// Something that happened to an entity during a sim step.
+struct SimEvent {
+    enum Type : std::uint8_t {
+        PLANE_SPAWNED,
+        PLANE_HIT,          // plane shot down by bullet
+        PLANE_EXPIRED,      // plane outlived LIFESPAN
+        BULLET_SPAWNED,
+        BULLET_EXPIRED,     // bullet outlived LIFESPAN_
+        BULLET_HIT_WORLD,   // bullet ran into static scenery
+    };
+    Type type;
+    EntityHandle plane;                      // plane events
+    std::uint32_t bullet = 0;                // BulletPool::id, fixed for the bullet's life
+    glm::vec3 position{0.f};                 // where it happened
+};
+
+// Bounded lock-free multi-producer, single-consumer queue of SimEvents.
+// Any thread may push(); one thread drains. Each cell carries a sequence
+// number that says whether it is free for the producer that reserved it or
+// holds an event ready for the consumer, so neither side ever blocks. When
+// the queue is full push() drops the event and counts it; size the queue
+// for the most events one drain interval can produce.
+class EventQueue {
+private:
+    struct Cell {
+        std::atomic<std::uint32_t> seq;
+        SimEvent event;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    std::uint32_t mask;
+    alignas(64) std::atomic<std::uint32_t> tail{0};   // next cell to reserve, shared by producers
+    alignas(64) std::uint32_t head{0};                // next cell to read, consumer only
+    std::atomic<std::uint64_t> droppedEvents{0};
+
+public:
+    explicit EventQueue(std::size_t capacity) {
+        std::uint32_t size = 64;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (std::uint32_t i = 0; i < size; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    bool push(const SimEvent& e) {
+        std::uint32_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & mask];
+            const std::uint32_t seq = c.seq.load(std::memory_order_acquire);
+            const std::int32_t diff = static_cast<std::int32_t>(seq - pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.event = e;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                droppedEvents.fetch_add(1, std::memory_order_relaxed);   // a lap behind: full
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer side
+    bool pop(SimEvent& out) {
+        Cell& c = cells[head & mask];
+        const std::uint32_t seq = c.seq.load(std::memory_order_acquire);
+        if (static_cast<std::int32_t>(seq - (head + 1)) < 0) return false;
+        out = c.event;
+        c.seq.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    // pops everything published so far into f(const SimEvent&)
+    template <typename F>
+    std::size_t drain(F&& f) {
+        std::size_t n = 0;
+        SimEvent e;
+        while (pop(e)) { f(e); ++n; }
+        return n;
+    }
+
+    std::size_t capacity() const { return std::size_t(mask) + 1; }
+    std::uint64_t dropped() const { return droppedEvents.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+// Lane helpers for the sphere test: 8 spheres per step on AVX2 builds,
+// 4 on SSE2, scalar otherwise.
+namespace frustum_simd {
+#if defined(__AVX2__)
+constexpr int WIDTH = 8;
+using vf = __m256;
+inline vf load(const float* p) { return _mm256_loadu_ps(p); }
+inline vf set1(float a) { return _mm256_set1_ps(a); }
+inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+inline vf orMask(vf a, vf b) { return _mm256_or_ps(a, b); }
+inline vf lt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline vf zero() { return _mm256_setzero_ps(); }
+inline int bits(vf m) { return _mm256_movemask_ps(m); }
+#elif defined(__SSE2__)
+constexpr int WIDTH = 4;
+using vf = __m128;
+inline vf load(const float* p) { return _mm_loadu_ps(p); }
+inline vf set1(float a) { return _mm_set1_ps(a); }
+inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+inline vf orMask(vf a, vf b) { return _mm_or_ps(a, b); }
+inline vf lt(vf a, vf b) { return _mm_cmplt_ps(a, b); }
+inline vf zero() { return _mm_setzero_ps(); }
+inline int bits(vf m) { return _mm_movemask_ps(m); }
+#else
+constexpr int WIDTH = 1;
+#endif
+} // namespace frustum_simd
+
+// The six planes of a projection * view matrix, normals pointing inwards
+// and normalised so plane distances are in world units. Extracted straight
+// from the matrix rows (Gribb & Hartmann), so it works for the perspective
+// camera and spot lights as well as orthographic lights.
+struct Frustum {
+    glm::vec4 planes[6];   // left, right, bottom, top, near, far: xyz normal, w offset
+
+    static Frustum FromMatrix(const glm::mat4& m) {
+        const glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        const glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        const glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        const glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        Frustum f;
+        f.planes[0] = r3 + r0;
+        f.planes[1] = r3 - r0;
+        f.planes[2] = r3 + r1;
+        f.planes[3] = r3 - r1;
+        f.planes[4] = r3 + r2;
+        f.planes[5] = r3 - r2;
+        for (glm::vec4& p : f.planes) p = p / glm::length(glm::vec3(p));
+        return f;
+    }
+
+    // conservative: spheres near a corner can pass without touching the volume
+    bool intersectsSphere(const glm::vec3& c, float r) const {
+        for (const glm::vec4& p : planes)
+            if (glm::dot(glm::vec3(p), c) + p.w < -r) return false;
+        return true;
+    }
+
+    // tests the box corner furthest along each plane normal
+    bool intersectsBox(const glm::vec3& lo, const glm::vec3& hi) const {
+        for (const glm::vec4& p : planes) {
+            const glm::vec3 far(p.x >= 0.f ? hi.x : lo.x, p.y >= 0.f ? hi.y : lo.y, p.z >= 0.f ? hi.z : lo.z);
+            if (glm::dot(glm::vec3(p), far) + p.w < 0.f) return false;
+        }
+        return true;
+    }
+};
+
+// Tests n spheres, given as separate x/y/z/radius arrays, against the
+// frustum and writes 1 (possibly visible) or 0 (outside) per sphere.
+// Negative radii mark things that are never culled. Returns how many
+// are visible.
+inline std::size_t CullSpheres(const Frustum& f, const float* x, const float* y, const float* z,
+                               const float* r, std::size_t n, std::uint8_t* visible)
+{
+    std::size_t i = 0, count = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    using namespace frustum_simd;
+    for (; i + WIDTH <= n; i += WIDTH) {
+        const vf cx = load(x + i), cy = load(y + i), cz = load(z + i), rad = load(r + i);
+        const vf negRad = mul(rad, set1(-1.f));
+        vf outside = zero();
+        for (const glm::vec4& p : f.planes) {
+            const vf d = add(add(mul(cx, set1(p.x)), mul(cy, set1(p.y))), add(mul(cz, set1(p.z)), set1(p.w)));
+            outside = orMask(outside, lt(d, negRad));
+        }
+        // negative radii are never culled
+        const int out = bits(outside) & ~bits(lt(rad, zero()));
+        for (int k = 0; k < WIDTH; ++k) {
+            visible[i + k] = ((out >> k) & 1) == 0;
+            count += visible[i + k];
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        visible[i] = r[i] < 0.f || f.intersectsSphere(glm::vec3(x[i], y[i], z[i]), r[i]);
+        count += visible[i];
+    }
+    return count;
+}
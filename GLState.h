@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// Changes issued to GL and changes dropped because GL was already in that state.
+struct GLStateCounters {
+    std::uint32_t issued = 0;
+    std::uint32_t filtered = 0;
+};
+
+// Shadow copy of the GL state the renderer touches: program, VAO, texture
+// bindings per unit, draw framebuffer, viewport, depth test and polygon
+// offset. Each setter compares against the copy and only calls GL when the
+// value changes, so draw helpers can set what they need without unbinding
+// afterwards, and the current state can be read without a glGet round trip.
+//
+// The copy is only right while every change goes through here; call
+// Invalidate() after raw GL calls that touch any of it.
+class GLState {
+private:
+    static constexpr int MAX_UNITS = 16;
+    enum Target { TEX_2D, TEX_2D_ARRAY, TARGETS, UNTRACKED = TARGETS };
+    static constexpr GLuint UNKNOWN = ~GLuint(0);
+
+    inline static GLuint program = UNKNOWN;
+    inline static GLuint vao = UNKNOWN;
+    inline static GLuint framebuffer = UNKNOWN;
+    inline static GLenum activeUnit = UNKNOWN;
+    inline static GLuint textures[MAX_UNITS][TARGETS];
+    inline static GLint viewport[4] = { -1, -1, -1, -1 };
+    inline static int depthTest = -1, polygonOffsetFill = -1;   // -1: unknown
+    inline static GLfloat offsetFactor = -1e30f, offsetUnits = -1e30f;
+    inline static GLStateCounters frame, lastFrame;
+
+    static Target slot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D:       return TEX_2D;
+            case GL_TEXTURE_2D_ARRAY: return TEX_2D_ARRAY;
+            default:                  return UNTRACKED;
+        }
+    }
+
+    // true when the caller should issue the change
+    static bool change(bool differs) {
+        if (differs) ++frame.issued;
+        else ++frame.filtered;
+        return differs;
+    }
+
+    static void activeTexture(GLenum unit) {
+        if (!change(activeUnit != unit)) return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+
+    static int& capability(GLenum cap) {
+        static int untracked;
+        if (cap == GL_DEPTH_TEST) return depthTest;
+        if (cap == GL_POLYGON_OFFSET_FILL) return polygonOffsetFill;
+        untracked = -1;
+        return untracked;
+    }
+
+public:
+    // forget everything, e.g. after code that drives GL directly
+    static void Invalidate() {
+        program = vao = framebuffer = activeUnit = UNKNOWN;
+        for (auto& unit : textures)
+            for (GLuint& t : unit) t = UNKNOWN;
+        viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+        depthTest = polygonOffsetFill = -1;
+        offsetFactor = offsetUnits = -1e30f;
+    }
+
+    static void UseProgram(GLuint id) {
+        if (!change(program != id)) return;
+        glUseProgram(id);
+        program = id;
+    }
+
+    static void BindVertexArray(GLuint id) {
+        if (!change(vao != id)) return;
+        glBindVertexArray(id);
+        vao = id;
+    }
+
+    // unit is 0-based, not GL_TEXTURE0-based
+    static void BindTexture(GLenum unit, GLenum target, GLuint texture) {
+        const Target s = slot(target);
+        const bool tracked = s != UNTRACKED && unit < MAX_UNITS;
+        if (!change(!tracked || textures[unit][s] != texture)) return;
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        if (tracked) textures[unit][s] = texture;
+    }
+
+    static void BindFramebuffer(GLuint id) {
+        if (!change(framebuffer != id)) return;
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+        framebuffer = id;
+    }
+
+    static void Viewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+        if (!change(viewport[0] != x || viewport[1] != y || viewport[2] != w || viewport[3] != h)) return;
+        glViewport(x, y, w, h);
+        viewport[0] = x; viewport[1] = y; viewport[2] = w; viewport[3] = h;
+    }
+
+    // GL_DEPTH_TEST and GL_POLYGON_OFFSET_FILL are tracked, other caps always go through
+    static void SetCapability(GLenum cap, bool on) {
+        int& known = capability(cap);
+        if (!change(known != int(on))) return;
+        if (on) glEnable(cap);
+        else glDisable(cap);
+        known = on;
+    }
+
+    static void PolygonOffset(GLfloat factor, GLfloat units) {
+        if (!change(offsetFactor != factor || offsetUnits != units)) return;
+        glPolygonOffset(factor, units);
+        offsetFactor = factor;
+        offsetUnits = units;
+    }
+
+    // what is bound, without asking the driver; 0 until something is bound here
+    static GLuint CurrentProgram() { return program == UNKNOWN ? 0 : program; }
+    static GLuint CurrentFramebuffer() { return framebuffer == UNKNOWN ? 0 : framebuffer; }
+
+    // call once per frame; the counts of the frame just finished move to LastFrame()
+    static void BeginFrame() {
+        lastFrame = frame;
+        frame = GLStateCounters{};
+    }
+    static const GLStateCounters& LastFrame() { return lastFrame; }
+};
@@ -0,0 +1,7 @@
+// Simulation benchmark without a window or GL. Builds with only glm:
+//   g++ -O2 HeadlessSim.cpp -o HeadlessSim -pthread
+#include "HeadlessSim.h"
+
+int main(int argc, char* argv[]) {
+  return RunHeadlessSim(argc, argv);
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <chrono>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "Bullet.h"
+#include "CommandLine.h"
+#include "JobSystem.h"
+#include "SimClock.h"
+#include "SimRandom.h"
+#include "SimWorld.h"
+
+// --headless-sim: steps the simulation with no window or GL context and
+// reports throughput, so sim scaling can be measured on machines without a
+// GPU. Planes and bullets are topped back up to the requested counts every
+// tick, so the load stays constant while hits and lifespans remove entities.
+//
+//   --planes N   --bullets M   --ticks T   --sim-hz HZ   --threads K   --seed S   --verify-simd
+//
+// --threads 1 runs the serial path, 0 (default) uses one worker per core.
+// The same seed gives the same run, whatever the thread count.
+// --verify-simd checks every plane step against the scalar path
+// (AirplaneFleet::verifyAgainstScalar) and fails the run on any difference.
+struct HeadlessSimOptions {
+    std::uint32_t planes = 256;
+    std::size_t bullets = 1024;
+    long ticks = 10000;
+    float tickHz = 60.f;
+    unsigned threads = 0;
+    std::uint64_t seed = 371;
+    bool verifySimd = false;
+    std::string error;   // set by ParseHeadlessSimOptions on a malformed value
+};
+
+// peak resident set size in KB, -1 where the platform doesn't report it
+inline long PeakRssKb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(__APPLE__)
+    return static_cast<long>(usage.ru_maxrss / 1024);   // bytes on macOS
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+inline HeadlessSimOptions ParseHeadlessSimOptions(int argc, char* argv[])
+{
+    HeadlessSimOptions o;
+    std::uint64_t n = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--verify-simd") o.verifySimd = true;
+        if (i + 1 == argc) break;
+        const char* value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--planes") {
+            ok = ParseUnsignedArg(value, std::numeric_limits<std::uint32_t>::max(), n);
+            if (ok) o.planes = static_cast<std::uint32_t>(n);
+        } else if (arg == "--bullets") {
+            ok = ParseUnsignedArg(value, std::numeric_limits<std::size_t>::max(), n);
+            if (ok) o.bullets = static_cast<std::size_t>(n);
+        } else if (arg == "--threads") {
+            ok = ParseUnsignedArg(value, std::numeric_limits<unsigned>::max(), n);
+            if (ok) o.threads = static_cast<unsigned>(n);
+        } else if (arg == "--ticks")  ok = ParseIntArg(value, o.ticks);
+        else if (arg == "--sim-hz")   ok = ParseFloatArg(value, o.tickHz);
+        else if (arg == "--seed")     ok = ParseUnsignedArg(value, std::numeric_limits<std::uint64_t>::max(), o.seed);
+        if (!ok) {
+            o.error = arg + ": not a valid number: \"" + value + "\"";
+            break;
+        }
+    }
+    return o;
+}
+
+inline int RunHeadlessSim(const HeadlessSimOptions& o)
+{
+    if (!o.error.empty()) {
+        std::cerr << "headless sim: " << o.error << "\n";
+        return 1;
+    }
+    if (!(o.tickHz >= SimClock::MIN_TICK_HZ && o.tickHz <= SimClock::MAX_TICK_HZ)) {
+        std::cerr << "headless sim: --sim-hz must be between " << SimClock::MIN_TICK_HZ
+                  << " and " << SimClock::MAX_TICK_HZ << "\n";
+        return 1;
+    }
+    if (o.ticks < 1) {
+        std::cerr << "headless sim: --ticks must be at least 1\n";
+        return 1;
+    }
+    std::unique_ptr<JobSystem> jobs;
+    if (o.threads != 1) jobs.reset(new JobSystem(o.threads));
+    SetSimSeed(o.seed);
+    SimWorld world(o.planes, o.bullets, jobs.get(), o.seed);
+    world.planes.verifyAgainstScalar = o.verifySimd;
+    const float dt = 1.f / o.tickHz;
+
+    // planes fly over a ground battery; spawn values are drawn in batches
+    SimRng rng(EntitySeed(o.seed, 0));
+    std::vector<float> u, picks;
+    auto topUp = [&]() {
+        const std::size_t newPlanes = o.planes - world.planes.liveCount();
+        const std::size_t newBullets = o.bullets - world.bullets.size();
+        u.resize(3 * (newPlanes + newBullets));
+        picks.resize(3 * newBullets);
+        rng.fillUniform(u.data(), u.size());
+        rng.fillPicks(picks.data(), picks.size());
+        auto spread = [&](std::size_t k) { return 2.f * u[k] - 1.f; };   // [-1, 1)
+
+        std::size_t k = 0;
+        for (std::size_t p = 0; p < newPlanes; ++p, k += 3)
+            world.spawnPlane(glm::vec3(40.f * spread(k), 20.f + 5.f * spread(k + 1), -30.f + 10.f * spread(k + 2)));
+        for (std::size_t b = 0; b < newBullets; ++b, k += 3) {
+            const glm::vec3 aim = glm::normalize(glm::vec3(0.5f * spread(k), 1.f, -0.6f + 0.4f * spread(k + 1)));
+            const glm::vec3 jitter(picks[3 * b], picks[3 * b + 1], picks[3 * b + 2]);
+            world.spawnBullet(Bullet(glm::vec3(20.f * spread(k + 2), 2.f, 0.f), aim, jitter));
+        }
+    };
+
+    topUp();
+    std::size_t hits = 0;
+    double entityTicks = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (long t = 0; t < o.ticks; ++t) {
+        topUp();
+        entityTicks += double(world.planes.liveCount()) + double(world.bullets.size());
+        world.step(dt);
+        for (const SimEvent& e : world.frameEvents()) hits += (e.type == SimEvent::PLANE_HIT);
+        world.clearFrameEvents();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "headless sim: " << o.planes << " planes, " << o.bullets << " bullets, "
+              << o.ticks << " ticks @ " << o.tickHz << " Hz, "
+              << (jobs ? jobs->threadCount() : 1u) << " thread(s)\n"
+              << "  wall " << seconds << " s, "
+              << (seconds > 0.0 ? o.ticks / seconds : 0.0) << " ticks/s, "
+              << (entityTicks > 0.0 ? seconds * 1e9 / entityTicks : 0.0) << " ns/entity-tick\n"
+              << "  hits " << hits << ", dropped events " << world.droppedEvents()
+              << ", peak RSS " << PeakRssKb() << " KB\n";
+    if (o.verifySimd) {
+        const std::size_t mismatches = world.planes.verifyMismatches.load();
+        std::cout << "  SIMD vs scalar: " << (mismatches == 0 ? "bit-identical" : "MISMATCH")
+                  << ", " << mismatches << " diverged block range(s)\n";
+        if (mismatches != 0) return 1;
+    }
+    return 0;
+}
+
+inline int RunHeadlessSim(int argc, char* argv[])
+{
+    return RunHeadlessSim(ParseHeadlessSimOptions(argc, argv));
+}
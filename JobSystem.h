@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Completion counter for a group of jobs. Jobs submitted with a dependency
+// on a counter are parked on it and queued once it drops to zero. Reset a
+// counter only after it has been waited on.
+class JobCounter {
+private:
+    friend class JobSystem;
+    struct Job {
+        void (*fn)(void* ctx, std::size_t lo, std::size_t hi) = nullptr;
+        void* ctx = nullptr;
+        std::size_t lo = 0, hi = 0;
+        JobCounter* signal = nullptr;
+    };
+
+    std::atomic<int> pending{0};
+    std::mutex m;
+    std::vector<Job> continuations;   // keeps its capacity between frames
+
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Small work-stealing pool. Every worker owns a fixed ring of jobs: it
+// pushes and pops at the back, idle workers steal from the front of the
+// others. The thread that waits on a counter helps run jobs instead of
+// blocking, so the main thread counts as one of the workers.
+// Job functors are referenced, not copied, and must outlive their counter.
+class JobSystem {
+private:
+    using Job = JobCounter::Job;
+    static constexpr std::size_t RING_SIZE = 4096;
+
+    struct Queue {
+        std::mutex m;
+        std::unique_ptr<Job[]> ring{ new Job[RING_SIZE] };
+        std::size_t head = 0, tail = 0;   // jobs live in [head, tail)
+
+        bool push(const Job& j) {
+            std::lock_guard<std::mutex> lock(m);
+            if (tail - head == RING_SIZE) return false;
+            ring[tail++ % RING_SIZE] = j;
+            return true;
+        }
+        bool popBack(Job& j) {
+            std::lock_guard<std::mutex> lock(m);
+            if (tail == head) return false;
+            j = ring[--tail % RING_SIZE];
+            return true;
+        }
+        bool popFront(Job& j) {
+            std::lock_guard<std::mutex> lock(m);
+            if (tail == head) return false;
+            j = ring[head++ % RING_SIZE];
+            return true;
+        }
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;   // index 0 belongs to the owning thread
+    std::vector<std::thread> workers;
+    std::atomic<bool> quit{false};
+    std::atomic<int> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    static std::size_t& threadIndex() {
+        static thread_local std::size_t index = 0;
+        return index;
+    }
+
+    void execute(const Job& j) {
+        j.fn(j.ctx, j.lo, j.hi);
+        if (j.signal) finish(*j.signal);
+    }
+
+    void finish(JobCounter& c) {
+        if (c.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        std::lock_guard<std::mutex> lock(c.m);
+        for (const Job& j : c.continuations) enqueue(j);
+        c.continuations.clear();
+    }
+
+    void enqueue(const Job& j) {
+        if (!queues[threadIndex() % queues.size()]->push(j)) {
+            execute(j);   // ring full: run it here rather than allocate
+            return;
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        wake.notify_one();
+    }
+
+    void submit(const Job& j, JobCounter* after) {
+        if (after) {
+            std::lock_guard<std::mutex> lock(after->m);
+            if (!after->done()) {
+                after->continuations.push_back(j);
+                return;
+            }
+        }
+        enqueue(j);
+    }
+
+    bool tryRunOne() {
+        const std::size_t self = threadIndex() % queues.size();
+        Job j;
+        bool got = queues[self]->popBack(j);
+        for (std::size_t k = 1; !got && k < queues.size(); ++k)
+            got = queues[(self + k) % queues.size()]->popFront(j);
+        if (!got) return false;
+        queued.fetch_sub(1, std::memory_order_acq_rel);
+        execute(j);
+        return true;
+    }
+
+    void workerLoop(std::size_t index) {
+        threadIndex() = index;
+        while (!quit.load(std::memory_order_acquire)) {
+            if (tryRunOne()) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(2), [this] {
+                return quit.load(std::memory_order_acquire) || queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    template <typename F>
+    static void callRange(void* ctx, std::size_t lo, std::size_t hi) { (*static_cast<F*>(ctx))(lo, hi); }
+    template <typename F>
+    static void callOnce(void* ctx, std::size_t, std::size_t) { (*static_cast<F*>(ctx))(); }
+
+public:
+    // threads = total workers including the calling thread; 0 picks one per core
+    explicit JobSystem(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) queues.emplace_back(new Queue());
+        threadIndex() = 0;
+        for (unsigned i = 1; i < threads; ++i) workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    ~JobSystem() {
+        quit.store(true, std::memory_order_release);
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned threadCount() const { return static_cast<unsigned>(queues.size()); }
+
+    // runs f() once; signals done when it finishes, optionally waits for after
+    template <typename F>
+    void run(F& f, JobCounter& done, JobCounter* after = nullptr) {
+        done.pending.fetch_add(1, std::memory_order_relaxed);
+        submit(Job{ &callOnce<F>, &f, 0, 0, &done }, after);
+    }
+
+    // splits [begin, end) into chunks of at least grain and runs f(lo, hi) on each
+    template <typename F>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, F& f,
+                     JobCounter& done, JobCounter* after = nullptr) {
+        if (end <= begin) return;
+        grain = std::max<std::size_t>(grain, 1);
+        const std::size_t n = end - begin;
+        const std::size_t maxChunks = std::min<std::size_t>((n + grain - 1) / grain, std::size_t(threadCount()) * 4);
+        const std::size_t size = (n + maxChunks - 1) / maxChunks;
+        const std::size_t chunks = (n + size - 1) / size;
+        done.pending.fetch_add(static_cast<int>(chunks), std::memory_order_relaxed);
+        for (std::size_t lo = begin; lo < end; lo += size)
+            submit(Job{ &callRange<F>, &f, lo, std::min(lo + size, end), &done }, after);
+    }
+
+    // helps with queued work until the counter reaches zero
+    void wait(JobCounter& c) {
+        while (!c.done())
+            if (!tryRunOne()) std::this_thread::yield();
+    }
+};
@@ -0,0 +1,287 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+#include "GLState.h"
+#include "ShaderProgram.h"
+
+// passes an item takes part in
+enum RenderPass : std::uint8_t {
+    PASS_SUN_SHADOW        = 1 << 0,
+    PASS_SPOT_SHADOW       = 1 << 1,   // spotlight layers, the floodlight's among them
+    PASS_SCENE             = 1 << 2,
+    PASS_SUN_STATIC        = 1 << 3,   // static casters, drawn into the cached sun map instead
+    PASS_SHADOWS           = PASS_SUN_SHADOW | PASS_SPOT_SHADOW,
+    PASS_ALL               = PASS_SHADOWS | PASS_SCENE,
+    PASS_ALL_STATIC        = PASS_SUN_STATIC | PASS_SPOT_SHADOW | PASS_SCENE,
+};
+
+// One thing to draw this frame. Items whose instance_mode is 1 or 2 get
+// their model matrix and propeller phase as instance attributes 3-7 (see
+// scene_vertex.glsl), in layered passes their layer mask as attribute 8,
+// and in the scene pass their normal matrix as attributes 9-11; mode 0
+// items are drawn as they are, e.g. vertices already in world space, and
+// never in layered passes.
+struct RenderItem {
+    GLuint program = 0;               // scene program; shadow passes draw with their own
+    GLuint vao = 0;
+    GLenum primitive = GL_TRIANGLES;
+    GLint first = 0;
+    GLsizei count = 0;                // vertices
+    GLuint texture = 0;               // unit 0, 0 for none
+    glm::vec2 uvScale{1.f};
+    int instanceMode = 1;             // 1: model, 2: propeller of model, 0: no instance data
+    glm::mat4 model{1.f};
+    glm::mat3 normalMatrix{1.f};      // NormalMatrix(model) (SceneMath.hpp), set with the model
+    float propPhase = 0.f;            // radians
+    std::uint8_t passes = PASS_ALL;
+    glm::vec4 bounds{0.f, 0.f, 0.f, -1.f};   // world bounding sphere, xyz centre, w radius; < 0 never culled
+};
+
+// Collects the frame's items and draws them pass by pass. Each flush()
+// sorts the pass's items by a 64-bit key, most expensive state first:
+//
+//   program:10 | texture:12 | vao:12 | instance mode:2 | submission order:20
+//
+// so program, texture and VAO changes happen once per group. Runs of items
+// that share all of that (and uv scale) become a single instanced draw;
+// their matrices are streamed to one buffer per pass, in sorted order.
+// Names wider than the key fields only cost sort quality, not correctness.
+class RenderQueue {
+private:
+    struct Packet {
+        std::uint64_t key;
+        std::uint32_t item;
+    };
+    struct Instance {
+        glm::mat4 model;
+        float propPhase;
+        std::uint32_t layers;   // layered passes: bit i draws into layer i
+        glm::mat3 normal;       // scene pass only, the shadow programs don't read it
+    };
+    static constexpr GLuint FIRST_INSTANCE_ATTRIB = 3;   // model columns 3-6, phase 7, layers 8, normal columns 9-11
+    static constexpr GLuint INSTANCE_ATTRIBS = 9;
+
+    std::vector<RenderItem> items;
+    std::vector<float> boundX, boundY, boundZ, boundR;   // items' bounds, split for CullSpheres
+    std::vector<std::uint8_t> visible;
+    std::vector<std::uint32_t> layerMasks;   // per item, for the layered pass being drawn
+    std::vector<Packet> packets;
+    std::vector<Instance> instances;
+    std::vector<GLuint> preparedVaos;   // instance attributes enabled, divisor 1
+    GLuint instanceVbo = 0;
+    std::size_t instanceCapacity = 0;
+    std::uint32_t lastBatches = 0;
+    std::uint32_t lastCulled = 0;
+
+    static std::uint64_t makeKey(GLuint program, GLuint texture, GLuint vao, int mode, std::uint32_t order) {
+        return (std::uint64_t(program & 0x3FF) << 46) | (std::uint64_t(texture & 0xFFF) << 34) |
+               (std::uint64_t(vao & 0xFFF) << 22) | (std::uint64_t(mode & 0x3) << 20) | (order & 0xFFFFF);
+    }
+
+    static bool sameBatch(const RenderItem& a, const RenderItem& b, bool materials) {
+        return a.vao == b.vao && a.primitive == b.primitive && a.first == b.first && a.count == b.count &&
+               a.instanceMode == b.instanceMode && a.instanceMode != 0 &&
+               (!materials || (a.program == b.program && a.texture == b.texture && a.uvScale == b.uvScale));
+    }
+
+    // attribute pointers for a batch starting at instance `base`
+    void pointInstances(GLuint vao, std::size_t base) {
+        if (std::find(preparedVaos.begin(), preparedVaos.end(), vao) == preparedVaos.end()) {
+            for (GLuint a = FIRST_INSTANCE_ATTRIB; a < FIRST_INSTANCE_ATTRIB + INSTANCE_ATTRIBS; ++a) {
+                glEnableVertexAttribArray(a);
+                glVertexAttribDivisor(a, 1);
+            }
+            preparedVaos.push_back(vao);
+        }
+        const std::size_t offset = base * sizeof(Instance);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        for (GLuint c = 0; c < 4; ++c)
+            glVertexAttribPointer(FIRST_INSTANCE_ATTRIB + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void*)(offset + offsetof(Instance, model) + c * sizeof(glm::vec4)));
+        glVertexAttribPointer(FIRST_INSTANCE_ATTRIB + 4, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void*)(offset + offsetof(Instance, propPhase)));
+        glVertexAttribIPointer(FIRST_INSTANCE_ATTRIB + 5, 1, GL_UNSIGNED_INT, sizeof(Instance),
+                               (void*)(offset + offsetof(Instance, layers)));
+        for (GLuint c = 0; c < 3; ++c)
+            glVertexAttribPointer(FIRST_INSTANCE_ATTRIB + 6 + c, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                  (void*)(offset + offsetof(Instance, normal) + c * sizeof(glm::vec3)));
+    }
+
+    // orphans the buffer, growing it when the pass has more instances than fit
+    void uploadInstances() {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        if (instances.size() > instanceCapacity) instanceCapacity = std::max(instances.size(), 2 * instanceCapacity);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    }
+
+    // sorts the packets and draws them in instanced runs; `program` as in flush()
+    void draw(GLuint program, bool layered) {
+        const bool materials = program == 0;
+        std::sort(packets.begin(), packets.end(), [](const Packet& a, const Packet& b) { return a.key < b.key; });
+
+        instances.clear();
+        for (const Packet& p : packets) {
+            const RenderItem& it = items[p.item];
+            if (it.instanceMode != 0)
+                instances.push_back(Instance{ it.model, it.propPhase, layered ? layerMasks[p.item] : 0u,
+                                              it.normalMatrix });
+        }
+        if (!instances.empty()) uploadInstances();
+
+        lastBatches = 0;
+        std::size_t base = 0;
+        for (std::size_t i = 0; i < packets.size();) {
+            const RenderItem& it = items[packets[i].item];
+            std::size_t end = i + 1;
+            while (end < packets.size() && sameBatch(it, items[packets[end].item], materials)) ++end;
+
+            ShaderProgram& p = ShaderProgram::Get(materials ? it.program : program);
+            p.set("instance_mode", it.instanceMode);
+            if (materials) {
+                p.set("uv_scale", it.uvScale);
+                if (it.texture) GLState::BindTexture(0, GL_TEXTURE_2D, it.texture);
+            }
+            GLState::BindVertexArray(it.vao);
+            if (it.instanceMode == 0) {
+                glDrawArrays(it.primitive, it.first, it.count);
+            } else {
+                pointInstances(it.vao, base);
+                glDrawArraysInstanced(it.primitive, it.first, it.count, static_cast<GLsizei>(end - i));
+                base += end - i;
+            }
+            ++lastBatches;
+            i = end;
+        }
+    }
+
+public:
+    explicit RenderQueue(std::size_t capacity = 1024) : instanceCapacity(capacity) {
+        items.reserve(capacity);
+        for (std::vector<float>* b : { &boundX, &boundY, &boundZ, &boundR }) b->reserve(capacity);
+        visible.reserve(capacity);
+        layerMasks.reserve(capacity);
+        packets.reserve(capacity);
+        instances.reserve(capacity);
+        glGenBuffers(1, &instanceVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    }
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // once per frame, before the items are submitted again
+    void clear() {
+        items.clear();
+        for (std::vector<float>* b : { &boundX, &boundY, &boundZ, &boundR }) b->clear();
+    }
+
+    void submit(const RenderItem& item) {
+        items.push_back(item);
+        boundX.push_back(item.bounds.x);
+        boundY.push_back(item.bounds.y);
+        boundZ.push_back(item.bounds.z);
+        boundR.push_back(item.bounds.w);
+    }
+
+    // Drops the pass from every item whose bounds lie outside the frustum,
+    // normally the pass's own projection * view. Call after the items are
+    // submitted and before flush(); returns how many items were dropped.
+    std::uint32_t cull(RenderPass pass, const Frustum& frustum) {
+        visible.resize(items.size());
+        CullSpheres(frustum, boundX.data(), boundY.data(), boundZ.data(), boundR.data(), items.size(), visible.data());
+        std::uint32_t culled = 0;
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (visible[i] || !(items[i].passes & pass)) continue;
+            items[i].passes &= ~pass;
+            ++culled;
+        }
+        lastCulled = culled;
+        return culled;
+    }
+
+    // Draws every item in the pass. A non-zero program replaces the items'
+    // own, and textures and uv scales are then left alone: the shadow passes
+    // only write depth.
+    void flush(RenderPass pass, GLuint program = 0) {
+        const bool materials = program == 0;
+        packets.clear();
+        for (std::uint32_t i = 0; i < items.size(); ++i) {
+            const RenderItem& it = items[i];
+            if (!(it.passes & pass) || it.count == 0) continue;
+            packets.push_back(Packet{ makeKey(materials ? it.program : program, materials ? it.texture : 0,
+                                              it.vao, it.instanceMode, i), i });
+        }
+        draw(program, false);
+    }
+
+    // Draws the pass once into every layer of a layered framebuffer that
+    // `layers` selects, with a program whose geometry shader sends each
+    // triangle to the layers in its instance's mask (shadow_geometry.glsl).
+    // Each item is culled against each selected layer's frustum, so it goes
+    // only to the layers it can show up in, and adding layers adds no draw
+    // calls. Mode 0 items are skipped. Returns how many items in the pass
+    // reached no layer.
+    std::uint32_t flushLayers(RenderPass pass, GLuint program, const Frustum* frustums, int layerCount,
+                              std::uint32_t layers) {
+        layerMasks.assign(items.size(), 0u);
+        visible.resize(items.size());
+        for (int l = 0; l < layerCount; ++l) {
+            if (!(layers & (1u << l))) continue;
+            CullSpheres(frustums[l], boundX.data(), boundY.data(), boundZ.data(), boundR.data(), items.size(),
+                        visible.data());
+            for (std::size_t i = 0; i < items.size(); ++i)
+                if (visible[i]) layerMasks[i] |= 1u << l;
+        }
+        packets.clear();
+        std::uint32_t culled = 0;
+        for (std::uint32_t i = 0; i < items.size(); ++i) {
+            const RenderItem& it = items[i];
+            if (!(it.passes & pass) || it.count == 0 || it.instanceMode == 0) continue;
+            if (layerMasks[i] == 0) {
+                ++culled;
+                continue;
+            }
+            packets.push_back(Packet{ makeKey(program, 0, it.vao, it.instanceMode, i), i });
+        }
+        draw(program, true);
+        return culled;
+    }
+
+    // FNV-1a hash of what the pass would draw as seen through viewProj: the
+    // geometry, transform and propeller phase of each item in the pass whose
+    // bounds reach into viewProj's frustum. Equal signatures give the same
+    // depth image, so a target whose signature hasn't changed can be kept.
+    std::uint64_t signature(RenderPass pass, const glm::mat4& viewProj) const {
+        const Frustum frustum = Frustum::FromMatrix(viewProj);
+        std::uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](const void* data, std::size_t bytes) {
+            const unsigned char* b = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < bytes; ++i) h = (h ^ b[i]) * 1099511628211ull;
+        };
+        mix(&viewProj[0][0], sizeof(glm::mat4));
+        for (const RenderItem& it : items) {
+            if (!(it.passes & pass) || it.count == 0) continue;
+            if (it.bounds.w >= 0.f && !frustum.intersectsSphere(glm::vec3(it.bounds), it.bounds.w)) continue;
+            const GLint geometry[4] = { GLint(it.vao), it.first, it.count, it.instanceMode };
+            mix(geometry, sizeof geometry);
+            mix(&it.model[0][0], sizeof(glm::mat4));
+            mix(&it.propPhase, sizeof(float));
+        }
+        return h;
+    }
+
+    std::size_t size() const { return items.size(); }
+    // draw calls issued by the last flush
+    std::uint32_t batches() const { return lastBatches; }
+    // items dropped by the last cull
+    std::uint32_t culled() const { return lastCulled; }
+};
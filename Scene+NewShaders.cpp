@@ -3,7 +3,6 @@
 #include <vector>
 
 #include <iostream>
-#include <list>
 
 #define GLEW_STATIC 1 // This allows linking with Static Library on Windows, without DLL
 #include <GL/glew.h>  // Include GLEW - OpenGL Extension Wrangler
@@ -21,6 +20,9 @@
 #include "shaderloader.h"
 #include "OBJloader.h"  //For loading .obj files
 #include "OBJloaderV3.h"  //For loading .obj files using a polygon list format
+#include "EntityPool.h"  //Fixed-capacity projectile storage
+#include "ShaderProgram.h"  //Cached uniform locations and values
+#include "UniformBlocks.h"  //Per-frame and light uniform buffers
 
 using namespace glm;
 using namespace std;
@@ -41,8 +43,11 @@ public:
         glBindTexture(GL_TEXTURE_2D, depthTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT,
             0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        // the scene shader samples it as sampler2DShadow
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
         float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -72,63 +77,47 @@ public:
     }
 };
 
-void setupSceneLighting(GLuint shaderProgram, vec3 lightPos, vec3 lightDir, vec3 lightColor, vec3 viewPos) {
-    glUseProgram(shaderProgram);
-
-    GLuint lightPosLoc = glGetUniformLocation(shaderProgram, "light_position");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "light_color");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "light_direction");
-    GLuint viewPosLoc = glGetUniformLocation(shaderProgram, "view_position");
-    GLuint objColorLoc = glGetUniformLocation(shaderProgram, "object_color");
-
-    glUniform3fv(lightPosLoc, 1, &lightPos[0]);
-    glUniform3fv(lightColorLoc, 1, &lightColor[0]);
-    glUniform3fv(lightDirLoc, 1, &glm::normalize(lightDir)[0]);
-    glUniform3fv(viewPosLoc, 1, &viewPos[0]);
-    glUniform3fv(objColorLoc, 1, &vec3(1.0f, 1.0f, 1.0f)[0]);
-
-    GLuint cutoffInnerLoc = glGetUniformLocation(shaderProgram, "light_cutoff_inner");
-    GLuint cutoffOuterLoc = glGetUniformLocation(shaderProgram, "light_cutoff_outer");
-    GLuint nearPlaneLoc = glGetUniformLocation(shaderProgram, "light_near_plane");
-    GLuint farPlaneLoc = glGetUniformLocation(shaderProgram, "light_far_plane");
-
-    glUniform1f(cutoffInnerLoc, glm::cos(glm::radians(12.5f)));
-    glUniform1f(cutoffOuterLoc, glm::cos(glm::radians(17.5f)));
-    glUniform1f(nearPlaneLoc, 1.0f);
-    glUniform1f(farPlaneLoc, 25.0f);
-
-    GLuint albedoLoc = glGetUniformLocation(shaderProgram, "albedo_tex");
-    GLuint shadowMapLoc = glGetUniformLocation(shaderProgram, "shadow_map");
-    glUniform1i(albedoLoc, 0);
-    glUniform1i(shadowMapLoc, 1);
+void setupSceneLighting(LightUniforms& lights, vec3 lightPos, vec3 lightDir, vec3 lightColor) {
+    lights.sun.position = lightPos;
+    lights.sun.direction = glm::normalize(lightDir);
+    lights.sun.color = lightColor;
+    lights.sun.intensity = 1.0f;
+    lights.sun.cutoffInner = glm::cos(glm::radians(12.5f));
+    lights.sun.cutoffOuter = glm::cos(glm::radians(17.5f));
+    lights.floodlight.intensity = 0.0f;
 }
 
 class Projectile
 {
 public:
-    Projectile(vec3 position, vec3 velocity, GLuint shaderProgram) : mPosition(position), mVelocity(velocity)
+    Projectile(vec3 position, vec3 velocity, GLuint shaderProgram) : mProgram(shaderProgram), mPosition(position), mVelocity(velocity)
     {
-        mWorldMatrixLocation = glGetUniformLocation(shaderProgram, "model_matrix"); // CHANGED
     }
 
     void Update(float dt)
     {
         mPosition += mVelocity * dt;
+        mAge += dt;
     }
 
+    // well past the far plane by then, so the slot can be reused
+    bool IsExpired() const { return mAge > 3.0f; }
+
     
     void Draw() {
         mat4 worldMatrix = translate(mat4(1.0f), mPosition) *
             rotate(mat4(1.0f), radians(180.0f), vec3(0.0f, 1.0f, 0.0f)) *
             scale(mat4(1.0f), vec3(0.02f, 0.02f, 0.02f));
-        glUniformMatrix4fv(mWorldMatrixLocation, 1, GL_FALSE, &worldMatrix[0][0]);
+        ShaderProgram::Get(mProgram).set("model_matrix", worldMatrix);
+        ShaderProgram::Get(mProgram).set("normal_matrix", transpose(inverse(mat3(worldMatrix))));
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
     }
 
 private:
-    GLuint mWorldMatrixLocation;
+    GLuint mProgram;
     vec3 mPosition;
     vec3 mVelocity;
+    float mAge = 0.0f;
 };
 
 GLuint loadTexture(const char* filename);
@@ -181,25 +170,11 @@ GLuint loadTexture(const char* filename)
 }
 
 
-void setProjectionMatrix(GLuint shaderProgram, mat4 projectionMatrix)
-{
-    glUseProgram(shaderProgram);
-    GLuint projectionMatrixLocation = glGetUniformLocation(shaderProgram, "projection_matrix"); // CHANGED
-    glUniformMatrix4fv(projectionMatrixLocation, 1, GL_FALSE, &projectionMatrix[0][0]);
-}
-
-void setViewMatrix(GLuint shaderProgram, mat4 viewMatrix)
-{
-    glUseProgram(shaderProgram);
-    GLuint viewMatrixLocation = glGetUniformLocation(shaderProgram, "view_matrix"); // CHANGED
-    glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, &viewMatrix[0][0]);
-}
-
 void setModelMatrix(GLuint shaderProgram, mat4 modelMatrix) //CHANGED
 {
-    glUseProgram(shaderProgram);
-    GLuint modelMatrixLocation = glGetUniformLocation(shaderProgram, "model_matrix"); // CHANGED
-    glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, &modelMatrix[0][0]);
+    ShaderProgram::Get(shaderProgram).set("model_matrix", modelMatrix);
+    // once per object here instead of once per vertex in scene_vertex.glsl
+    ShaderProgram::Get(shaderProgram).set("normal_matrix", transpose(inverse(mat3(modelMatrix))));
 }
 
 // Draw gun (FINAL UPDATED)
@@ -797,7 +772,7 @@ public:
     Light(vec3 pos) : position(pos) {}
 };
 //FINAL UPDATED
-list<Projectile> projectileList;
+EntityPool<Projectile> projectileList(256);
 
 int main(int argc, char* argv[])
 {
@@ -834,10 +809,23 @@ int main(int argc, char* argv[])
 
     //Initialize shaders
     std::string shaderPathPrefix = "Shaders/";
+    // sun only: this scene binds no floodlight shadow map
     GLuint shaderScene = loadSHADER(shaderPathPrefix + "scene_vertex.glsl",
-        shaderPathPrefix + "scene_fragment.glsl");
+        shaderPathPrefix + "scene_fragment.glsl", "#define NO_FLOODLIGHT\n");
     GLuint shaderShadow = loadSHADER(shaderPathPrefix + "shadow_vertex.glsl",
         shaderPathPrefix + "shadow_fragment.glsl");
+    BindUniformBlocks(shaderScene);
+    BindUniformBlocks(shaderShadow);
+    UniformBuffer frameBuffer(FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+    UniformBuffer lightBuffer(LIGHT_UNIFORMS_BINDING, sizeof(LightUniforms));
+    FrameUniforms frameUniforms;
+    LightUniforms lightUniforms;
+
+    ShaderProgram& sceneProgram = ShaderProgram::Get(shaderScene);
+    sceneProgram.set("object_color", vec3(1.0f, 1.0f, 1.0f));
+    sceneProgram.set("albedo_tex", 0);
+    sceneProgram.set("shadow_map", 1);
+    sceneProgram.set("pcf_taps", 4);
 
 
     // Load Textures
@@ -984,14 +972,24 @@ int main(int argc, char* argv[])
 
         // ===== SHADOW PASS =====
         shadowFB->bindForWriting();
-        glUseProgram(shaderShadow);
-
-        GLuint transformLoc = glGetUniformLocation(shaderShadow, "transform_in_light_space");
+        // Set matrices and lights, shared by both passes
+        mat4 viewMatrix = lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
+        frameUniforms.view = viewMatrix;
+        frameUniforms.projection = projectionMatrix;
+        frameUniforms.lightProjView = lightSpaceMatrix;
+        frameUniforms.viewPosition = vec4(cameraPosition, 1.0f);
+        frameBuffer.update(frameUniforms);
+        setupSceneLighting(lightUniforms, lightPos, lightDir, lightColor);
+        lightBuffer.update(lightUniforms);
+
+        ShaderProgram& shadowProgram = ShaderProgram::Get(shaderShadow);
+        shadowProgram.use();
+        shadowProgram.set("shadow_light", int(SHADOW_SUN));
 
         // Render ground to shadow map
         mat4 groundWorldMatrix = translate(mat4(1.0f), vec3(0.0f, -0.01f, 0.0f)) *
             scale(mat4(1.0f), vec3(100.0f, 0.02f, 100.0f));
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &(lightSpaceMatrix * groundWorldMatrix)[0][0]);
+        shadowProgram.set("model_matrix", groundWorldMatrix);
         glBindVertexArray(texturedGround);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
@@ -999,13 +997,13 @@ int main(int argc, char* argv[])
         mat4 tankWorldMatrix = translate(mat4(1.0f), tankPosition) *
             rotate(mat4(1.0f), radians(tankRotationY + 180.0f), vec3(0.0f, 1.0f, 0.0f)) *
             scale(mat4(1.0f), vec3(0.4f, 0.4f, 0.4f));
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &(lightSpaceMatrix * tankWorldMatrix)[0][0]);
+        shadowProgram.set("model_matrix", tankWorldMatrix);
         glBindVertexArray(tankVAO);
         glDrawElements(GL_TRIANGLES, tankVertices, GL_UNSIGNED_INT, 0);
 
         // Render other objects to shadow map
         mat4 prismWorldMatrix = translate(mat4(1.0f), vec3(0.0f, 0.5f, 0.8f));
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &(lightSpaceMatrix * prismWorldMatrix)[0][0]);
+        shadowProgram.set("model_matrix", prismWorldMatrix);
         glBindVertexArray(texturedVaoPrism);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
@@ -1013,18 +1011,8 @@ int main(int argc, char* argv[])
 
         // ===== SCENE PASS =====
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shaderScene);
-
-        // Set matrices
-        mat4 viewMatrix = lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
-        setProjectionMatrix(shaderScene, projectionMatrix);
-        setViewMatrix(shaderScene, viewMatrix);
-
-        GLuint lightProjViewLoc = glGetUniformLocation(shaderScene, "light_proj_view_matrix");
-        glUniformMatrix4fv(lightProjViewLoc, 1, GL_FALSE, &lightSpaceMatrix[0][0]);
-
-        // Setup lighting
-        setupSceneLighting(shaderScene, lightPos, lightDir, lightColor, cameraPosition);
+        sceneProgram.use();
+        sceneProgram.set("object_color", vec3(1.0f, 1.0f, 1.0f));
 
         // Bind shadow texture
         shadowFB->bindShadowTexture(GL_TEXTURE1);
@@ -1058,10 +1046,9 @@ int main(int argc, char* argv[])
         glDrawArrays(GL_TRIANGLES, 0, 18);
 
         // For colored objects, set object_color uniform
-        GLuint objColorLoc = glGetUniformLocation(shaderScene, "object_color");
 
         // Draw tank (olive green)
-        glUniform3f(objColorLoc, 0.4f, 0.6f, 0.4f);
+        sceneProgram.set("object_color", vec3(0.4f, 0.6f, 0.4f));
         setModelMatrix(shaderScene, tankWorldMatrix);
         glBindVertexArray(tankVAO);
         glDrawElements(GL_TRIANGLES, tankVertices, GL_UNSIGNED_INT, 0);
@@ -1072,7 +1059,7 @@ int main(int argc, char* argv[])
             vec3(cos(radians(spinningCubeAngle)) * orbitRadius2, 0.0f, sin(radians(spinningCubeAngle)) * orbitRadius2);
 
         // Center cube (red)
-        glUniform3f(objColorLoc, 6.0f, 0.0f, 0.0f);
+        sceneProgram.set("object_color", vec3(6.0f, 0.0f, 0.0f));
         mat4 centreCube = translate(mat4(1.0f), vec3(0.0f, 6.0f, 0.0f)) *
             rotate(mat4(1.0f), radians(spinningCubeAngle), vec3(0.0f, 1.0f, 0.0f)) *
             scale(mat4(1.0f), vec3(0.1f));
@@ -1081,7 +1068,7 @@ int main(int argc, char* argv[])
         glDrawElements(GL_TRIANGLES, cubeVertices, GL_UNSIGNED_INT, 0);
 
         // Orbiting cube (green)
-        glUniform3f(objColorLoc, 0.0f, 6.0f, 0.0f);
+        sceneProgram.set("object_color", vec3(0.0f, 6.0f, 0.0f));
         mat4 orbitingCube1 = translate(mat4(1.0f), orbitingCube1Position) *
             rotate(mat4(1.0f), radians(spinningCubeAngle), vec3(0.0f, 1.0f, 0.0f)) *
             scale(mat4(1.0f), vec3(0.07f));
@@ -1090,12 +1077,15 @@ int main(int argc, char* argv[])
         glDrawElements(GL_TRIANGLES, cubeVertices, GL_UNSIGNED_INT, 0);
 
         // Update and draw projectiles
-        glUniform3f(objColorLoc, 3.0f, 1.8f, 0.6f);
-        for (list<Projectile>::iterator it = projectileList.begin(); it != projectileList.end(); ++it)
+        sceneProgram.set("object_color", vec3(3.0f, 1.8f, 0.6f));
+        projectileList.forEach([&](EntityHandle h, Projectile& projectile)
         {
-            it->Update(dt);
-            it->Draw();
-        }
+            projectile.Update(dt);
+            if (projectile.IsExpired())
+                projectileList.despawn(h);
+            else
+                projectile.Draw();
+        });
 
         // End Frame
         glfwSwapBuffers(window);
@@ -1145,7 +1135,7 @@ int main(int argc, char* argv[])
             vec3 projectileDirection = normalize(targetPoint - spawnPosition);
 
             // Create projectile that travels from tank toward camera center
-            projectileList.push_back(Projectile(spawnPosition, projectileSpeed * projectileDirection, shaderScene));
+            projectileList.spawn(spawnPosition, projectileSpeed * projectileDirection, shaderScene);
         }
         lastMouseLeftState = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
 
@@ -1303,12 +1293,6 @@ int main(int argc, char* argv[])
 
         // Position camera at fixed offset from tank
         cameraPosition = tankPosition + vec3(0.0f, cameraHeight, cameraDistance);
-
-        // Update view matrix  
-        viewMatrix = lookAt(cameraPosition, cameraPosition + cameraLookAt, cameraUp);
-        glUseProgram(shaderScene);  // Make sure correct shader is active
-        GLuint viewMatrixLocation = glGetUniformLocation(shaderScene, "view_matrix");  // Correct name
-        glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, &viewMatrix[0][0]);
     }
 
     // Shutdown GLFW
@@ -1,4 +1,6 @@
 #include "Scene.h"
+#include "GLState.h"
+#include "ShaderProgram.h"
 #include <iostream>
 #include "stb/stb_image.h"
 
@@ -50,7 +52,7 @@ void Scene::CreateGroundPlane()
     };
 
     glGenVertexArrays(1, &m_groundVAO);
-    glBindVertexArray(m_groundVAO);
+    GLState::BindVertexArray(m_groundVAO);
 
     glGenBuffers(1, &m_groundVBO);
     glBindBuffer(GL_ARRAY_BUFFER, m_groundVBO);
@@ -72,7 +74,7 @@ void Scene::CreateGroundPlane()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 }
 
 void Scene::Render(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, GLuint groundTexture)
@@ -104,32 +106,27 @@ void Scene::RenderGroundPlane(const glm::mat4& viewMatrix, const glm::mat4& proj
 
 
     // Set model matrix
-    GLint currentProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+    const GLuint currentProgram = GLState::CurrentProgram();
 
     if (currentProgram == 0) {
         std::cerr << "ERROR: No shader program active!" << std::endl;
         return;
     }
 
-    GLint modelLocation = glGetUniformLocation(currentProgram, "model_matrix");
-    if (modelLocation != -1) {
-        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &groundModel[0][0]);
-    }
+    ShaderProgram::Get(currentProgram).set("model_matrix", groundModel);
+    ShaderProgram::Get(currentProgram).set("normal_matrix", glm::mat3(1.0f));
 
     // Bind grass texture to unit 0
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, groundTexture);
+    GLState::BindTexture(0, GL_TEXTURE_2D, groundTexture);
 
     // Render the ground plane
-    glBindVertexArray(m_groundVAO);
+    GLState::BindVertexArray(m_groundVAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 
     std::cout << "RenderGroundPlane completed" << std::endl;
 }
 
-void Scene::RenderGroundShadow(const glm::mat4& lightProjView)
+void Scene::RenderGroundShadow()
 {
     std::cout << "RenderGroundShadow called" << std::endl;
 
@@ -148,8 +145,7 @@ void Scene::RenderGroundShadow(const glm::mat4& lightProjView)
     glm::mat4 groundModel = glm::mat4(1.0f);
     std::cout << "Created ground model matrix" << std::endl;
 
-    GLint currentProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+    const GLuint currentProgram = GLState::CurrentProgram();
     std::cout << "Shadow shader program: " << currentProgram << std::endl;
 
     if (currentProgram == 0) {
@@ -157,22 +153,14 @@ void Scene::RenderGroundShadow(const glm::mat4& lightProjView)
         return;
     }
 
-    GLint transformLocation = glGetUniformLocation(currentProgram, "transform_in_light_space");
-    std::cout << "Transform location: " << transformLocation << std::endl;
-
-    if (transformLocation != -1) {
-        std::cout << "About to set transform uniform" << std::endl;
-        glm::mat4 transform = lightProjView * groundModel;
-        glUniformMatrix4fv(transformLocation, 1, GL_FALSE, &transform[0][0]);
-        std::cout << "Set transform uniform successfully" << std::endl;
-    }
+    // the light's projection * view comes from the FrameUniforms block
+    ShaderProgram::Get(currentProgram).set("model_matrix", groundModel);
 
     std::cout << "About to bind VAO and draw" << std::endl;
-    glBindVertexArray(m_groundVAO);
+    GLState::BindVertexArray(m_groundVAO);
     std::cout << "VAO bound, about to draw elements" << std::endl;
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     std::cout << "Draw elements completed" << std::endl;
-    glBindVertexArray(0);
     std::cout << "Shadow render completed" << std::endl;
 }
 
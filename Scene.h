@@ -15,7 +15,7 @@ public:
     void Render(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, GLuint groundTexture);
     void Cleanup();
 
-    void RenderGroundShadow(const glm::mat4& lightProjView);
+    void RenderGroundShadow();
     GLuint GetGroundVAO() const { return m_groundVAO; }
 
 private:
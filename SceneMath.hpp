@@ -0,0 +1,74 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Airplane.h"
+#include "AirplaneFleet.h"
+
+// Model matrices for the scene objects. Pure math, no GL, so the sim and
+// anything else that needs transforms can use them without a context.
+namespace utils {
+
+inline glm::mat4 BuildPlaneBaseModel(const glm::vec3& pos, const glm::mat4& yaw, float bankRollDeg) {
+  using namespace glm;
+  const mat4 T   = translate(mat4(1.f), pos);
+  const mat4 Br  = rotate(mat4(1.f), radians(bankRollDeg), vec3(0,0,1));
+  const mat4 Fix = rotate(mat4(1.f), radians(-90.f), vec3(1,0,0)); // model axis fix
+  const mat4 S   = scale(mat4(1.f), vec3(0.2f));
+  return T * yaw * Br * Fix * S;
+}
+
+inline glm::mat4 BuildPlaneBaseModel(const Airplane& p) {
+  return BuildPlaneBaseModel(p.position(), p.velocityYawMatrix(), p.bankRollDeg());
+}
+
+inline glm::mat4 BuildPlaneBaseModel(const AirplaneFleet& fleet, std::size_t i, float alpha = 1.f) {
+  using namespace glm;
+  const vec3 v = fleet.velocity(i);
+  const mat4 Y = (length(v) < 1e-5f) ? mat4(1.f)
+                                     : rotate(mat4(1.f), std::atan2(v.x, v.z), vec3(0.f, 1.f, 0.f));
+  return BuildPlaneBaseModel(fleet.interpolatedPosition(i, alpha), Y, fleet.bankRollDeg(i));
+}
+
+// turns normals the way model turns surfaces, also under non-uniform scale
+inline glm::mat3 NormalMatrix(const glm::mat4& model) {
+  return glm::transpose(glm::inverse(glm::mat3(model)));
+}
+
+inline glm::mat4 BuildBulletBaseModel(const glm::vec3& bulletPos) {
+  using namespace glm;
+  const mat4 T   = translate(mat4(1.f), bulletPos);
+  const mat4 S   = scale(mat4(1.f), vec3(0.01f));
+  return T * S;
+}
+
+inline glm::mat4 BuildFloorBaseModel() {
+  using namespace glm;
+  const mat4 T = translate(mat4(1.f), vec3(0.f, -3.f, 0.f));
+  const mat4 S = scale(mat4(1.f), vec3(40.f, 0.3f, 40.f));
+  return T * S;
+}
+
+inline glm::mat4 BuildCubeModel() {
+  using namespace glm;
+  return scale(mat4(1.f), vec3(2.f)) * translate(mat4(1.f), vec3(0.f, -.5f, 20.f)) * rotate(mat4(1.f), radians(45.f), normalize(vec3(1,1,1)));
+}
+
+inline glm::mat4 BuildTankModel(const glm::vec3& pos, const glm::vec3& lookDir) {
+  using namespace glm;
+  glm::vec3 f = lookDir;
+  f.y = 0.0f; f = glm::normalize(f);
+
+  float yaw = -std::atan2(f.x, -f.z);          
+  const glm::mat4 T   = glm::translate(glm::mat4(1.f), pos);
+  const glm::mat4 Y   = glm::rotate(glm::mat4(1.f), yaw, glm::vec3(0,1,0));
+  const glm::mat4 Fix = glm::rotate(glm::mat4(1.f), radians(180.f), vec3(0,1,0));
+  const glm::mat4 S   = glm::mat4(1.f);
+
+  return T * Y * Fix * S;
+}
+
+} // namespace utils
@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLState.h"
+
+// A linked GL program with its uniforms reflected once: every active
+// uniform's location is looked up when the program is first seen, along
+// with room for the last value uploaded to it. set() compares against that
+// value and skips the glUniform call when nothing changed; binding goes
+// through GLState, which skips it when the program is already bound.
+// Setting a uniform still binds its program, as the old utils::SetUniform*
+// helpers did.
+//
+// The cache only holds while every upload goes through here; code that
+// calls glUniform* directly must call Invalidate().
+class ShaderProgram {
+private:
+    struct Uniform {
+        std::string name;
+        GLint location;
+        int size = 0;        // floats in the cached value, 0 until first upload
+        float value[16] = {};
+    };
+
+    GLuint program = 0;
+    std::vector<Uniform> uniforms;   // sorted by name
+
+    inline static std::unordered_map<GLuint, ShaderProgram> programs;
+
+    void reflect() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> buffer(std::max(maxLength, 1) + 16);
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint arraySize = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length,
+                               &arraySize, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            const GLint location = glGetUniformLocation(program, name.c_str());
+            if (location < 0) continue;   // uniform block member
+            uniforms.push_back(Uniform{ name, location });
+            // arrays report "name[0]": also file the bare name and every element
+            const std::size_t bracket = name.rfind("[0]");
+            if (bracket == std::string::npos || bracket + 3 != name.size()) continue;
+            const std::string base = name.substr(0, bracket);
+            uniforms.push_back(Uniform{ base, location });
+            for (GLint k = 1; k < arraySize; ++k) {
+                const std::string element = base + "[" + std::to_string(k) + "]";
+                uniforms.push_back(Uniform{ element, glGetUniformLocation(program, element.c_str()) });
+            }
+        }
+        std::sort(uniforms.begin(), uniforms.end(),
+                  [](const Uniform& a, const Uniform& b) { return a.name < b.name; });
+    }
+
+    Uniform* find(const char* name) {
+        auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name,
+                                   [](const Uniform& u, const char* n) { return std::strcmp(u.name.c_str(), n) < 0; });
+        return (it != uniforms.end() && it->name == name) ? &*it : nullptr;
+    }
+
+    // binds the program and returns the uniform when v differs from its last upload
+    Uniform* changed(const char* name, const float* v, int size) {
+        use();
+        Uniform* u = find(name);
+        if (!u || (u->size == size && std::memcmp(u->value, v, size * sizeof(float)) == 0)) return nullptr;
+        std::memcpy(u->value, v, size * sizeof(float));
+        u->size = size;
+        return u;
+    }
+
+public:
+    ShaderProgram() = default;
+    explicit ShaderProgram(GLuint id) : program(id) { reflect(); }
+
+    // the wrapper for a program id, reflected the first time the id is seen
+    static ShaderProgram& Get(GLuint id) {
+        auto it = programs.find(id);
+        if (it == programs.end()) it = programs.emplace(id, ShaderProgram(id)).first;
+        return it->second;
+    }
+
+    static void Use(GLuint id) { GLState::UseProgram(id); }
+
+    // forget every cached value, e.g. after raw glUniform calls
+    static void Invalidate() {
+        for (auto& p : programs)
+            for (Uniform& u : p.second.uniforms) u.size = 0;
+    }
+
+    GLuint id() const { return program; }
+    void use() const { Use(program); }
+
+    // -1 for names the linker dropped or never saw
+    GLint location(const char* name) {
+        const Uniform* u = find(name);
+        return u ? u->location : -1;
+    }
+
+    void set(const char* name, float v) {
+        if (Uniform* u = changed(name, &v, 1)) glUniform1f(u->location, v);
+    }
+    void set(const char* name, int v) {
+        float bits;
+        std::memcpy(&bits, &v, sizeof bits);
+        if (Uniform* u = changed(name, &bits, 1)) glUniform1i(u->location, v);
+    }
+    void set(const char* name, const glm::vec2& v) {
+        if (Uniform* u = changed(name, &v[0], 2)) glUniform2fv(u->location, 1, &v[0]);
+    }
+    void set(const char* name, const glm::vec3& v) {
+        if (Uniform* u = changed(name, &v[0], 3)) glUniform3fv(u->location, 1, &v[0]);
+    }
+    void set(const char* name, const glm::mat3& m) {
+        if (Uniform* u = changed(name, &m[0][0], 9)) glUniformMatrix3fv(u->location, 1, GL_FALSE, &m[0][0]);
+    }
+    void set(const char* name, const glm::mat4& m) {
+        if (Uniform* u = changed(name, &m[0][0], 16)) glUniformMatrix4fv(u->location, 1, GL_FALSE, &m[0][0]);
+    }
+};
@@ -0,0 +1,14 @@
+#version 330 core
+
+uniform vec3 bullet_color;
+
+out vec4 result;
+
+void main()
+{
+    // round sprite with a brighter core
+    vec2 d = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(d, d);
+    if (r2 > 1.0) discard;
+    result = vec4(bullet_color * (1.5 - r2), 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 in_position;   // bullet centre, world space
+
+// per-frame values, shared with every program (UniformBlocks.h)
+layout (std140) uniform FrameUniforms {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    mat4 light_proj_view_matrix;
+    mat4 camLight_proj_view_matrix;
+    vec4 view_position;          // xyz
+    mat4 sun_cascade_matrices[4];   // SUN_CASCADE_COUNT
+    vec4 sun_cascade_splits;     // view distance each cascade ends at
+};
+
+uniform float bullet_size;     // world-space diameter
+uniform float viewport_height;
+
+void main()
+{
+    gl_Position = projection_matrix * view_matrix * vec4(in_position, 1.0);
+    // perspective size in pixels, never smaller than a couple of pixels
+    float point_scale = 0.5 * viewport_height * projection_matrix[1][1];
+    gl_PointSize = max(bullet_size * point_scale / gl_Position.w, 2.0);
+}
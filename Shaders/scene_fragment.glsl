@@ -2,16 +2,35 @@
 
 const float PI = 3.1415926535897932384626433832795;
 
-uniform vec3 light_color;
-uniform vec3 light_position;
-uniform vec3 light_direction;
-
-uniform vec3  camLight_position;
-uniform vec3  camLight_direction;
-uniform vec3  camLight_color;
-uniform float camLight_cutoff_inner;
-uniform float camLight_cutoff_outer;
-uniform float camLight_intensity;
+// per-frame values, shared with every program (UniformBlocks.h)
+layout (std140) uniform FrameUniforms {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    mat4 light_proj_view_matrix;
+    mat4 camLight_proj_view_matrix;
+    vec4 view_position;          // xyz
+    mat4 sun_cascade_matrices[4];   // SUN_CASCADE_COUNT
+    vec4 sun_cascade_splits;     // view distance each cascade ends at
+};
+
+struct SpotLight {
+    vec3  position;
+    float intensity;
+    vec3  direction;
+    float cutoff_inner;   // cosines
+    vec3  color;
+    float cutoff_outer;
+};
+
+layout (std140) uniform LightUniforms {
+    SpotLight sun_light;
+    SpotLight cam_light;     // floodlight on the tank, intensity 0 when off
+};
+
+// SUN_CASCADES builds take the sun's shadows from the cascade array
+// (ShadowCascades.h) instead of the single light_proj_view_matrix map.
+// NO_FLOODLIGHT builds (shaderSceneSun in the main file) light with the sun alone and never read
+// spot_shadow_maps, so the floodlight shadow pass can be skipped while it's off
 
 uniform vec3 object_color;   // tinting
 
@@ -19,23 +38,22 @@ const float shading_ambient_strength    = 0.05;
 const float shading_diffuse_strength    = 0.5;
 const float shading_specular_strength   = 0.9;
 
-uniform float light_cutoff_outer;
-uniform float light_cutoff_inner;
-uniform float light_near_plane;
-uniform float light_far_plane;
-
-
-
-uniform vec3 view_position;
-uniform sampler2D cam_shadow_map;  // bind on unit 2
-uniform sampler2D shadow_map;  // bind on unit 1
+// depth maps are sampled with GL_COMPARE_REF_TO_TEXTURE and linear
+// filtering, so every lookup is already a bilinear 2x2 comparison
+#ifndef NO_FLOODLIGHT
+uniform sampler2DArrayShadow spot_shadow_maps;  // bind on unit 2, one layer per spotlight, the floodlight is layer 0
+#endif
+#ifdef SUN_CASCADES
+uniform sampler2DArrayShadow shadow_map;  // bind on unit 1, one layer per cascade
+#else
+uniform sampler2DShadow shadow_map;  // bind on unit 1
+#endif
+uniform int pcf_taps;        // lookups per shadow test: 1, 4 or 16 (anything else is 1)
 uniform sampler2D albedo_tex;  // bind on unit 0
 
 uniform vec2 uv_scale;
 
 in vec3 fragment_position;
-in vec4 fragment_position_light_space;
-in vec4 fragment_position_camLight_space;
 in vec3 fragment_normal;
 in vec2 vUV;                   // from vertex shader
 
@@ -52,32 +70,105 @@ vec3 diffuse_color(vec3 light_color_arg, vec3 light_position_arg) {
 
 vec3 specular_color(vec3 light_color_arg, vec3 light_position_arg) {
     vec3 L = normalize(light_position_arg - fragment_position);
-    vec3 V = normalize(view_position - fragment_position);
+    vec3 V = normalize(view_position.xyz - fragment_position);
     vec3 R = reflect(-L, normalize(fragment_normal));
     return shading_specular_strength * light_color_arg * pow(max(dot(R, V), 0.0), 32.0);
 }
 
+// Poisson disk in the unit circle, for the 16-tap kernel
+const vec2 poisson_disk[16] = vec2[16](
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760),
+    vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.97484398,  0.75648379),
+    vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2( 0.79197514,  0.19090188),
+    vec2(-0.24188840,  0.99706507), vec2(-0.81409955,  0.91437590),
+    vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100790));
+
+int pcf_count() {
+    return (pcf_taps == 4 || pcf_taps == 16) ? pcf_taps : 1;
+}
+
+// offset of lookup i in texels: the 4-tap kernel covers a 3x3 texel
+// footprint, the Poisson one a disk 3 texels across
+vec2 pcf_offset(int i, int taps) {
+    if (taps == 16) return poisson_disk[i] * 1.5;
+    if (taps == 4) return vec2(i % 2 == 0 ? -0.5 : 0.5, i < 2 ? -0.5 : 0.5);
+    return vec2(0.0);
+}
+
+// fraction of the lookups whose stored depth is at least coord.z
+float pcf(sampler2DShadow map, vec3 coord) {
+    vec2 texel = 1.0 / vec2(textureSize(map, 0));
+    int taps = pcf_count();
+    float sum = 0.0;
+    for (int i = 0; i < taps; ++i) {
+        sum += texture(map, vec3(coord.xy + pcf_offset(i, taps) * texel, coord.z));
+    }
+    return sum / float(taps);
+}
+
+float pcf(sampler2DArrayShadow map, vec3 coord, float layer) {
+    vec2 texel = 1.0 / vec2(textureSize(map, 0).xy);
+    int taps = pcf_count();
+    float sum = 0.0;
+    for (int i = 0; i < taps; ++i) {
+        sum += texture(map, vec4(coord.xy + pcf_offset(i, taps) * texel, layer, coord.z));
+    }
+    return sum / float(taps);
+}
+
+// depth bias scaled by how steeply the light grazes the surface (tan of
+// the angle between normal and light, clamped): faces turned to the light
+// get little, grazing ones enough to keep acne off
+float slope_bias(vec3 to_light, float base) {
+    float cos_theta = clamp(dot(normalize(fragment_normal), to_light), 0.05, 1.0);
+    float tan_theta = sqrt(1.0 - cos_theta * cos_theta) / cos_theta;
+    return base * clamp(tan_theta, 1.0, 8.0);
+}
+
+#ifdef SUN_CASCADES
+// the first cascade that reaches this fragment's view distance
 float shadow_scalar() {
-    vec3 ndc = fragment_position_light_space.xyz / fragment_position_light_space.w;
+    float viewDepth = -(view_matrix * vec4(fragment_position, 1.0)).z;
+    int cascade = 0;
+    while (cascade < 3 && viewDepth > sun_cascade_splits[cascade]) ++cascade;
+    if (viewDepth > sun_cascade_splits[3]) {
+        return 1.0;   // past the shadow distance
+    }
+    vec3 ndc = (sun_cascade_matrices[cascade] * vec4(fragment_position, 1.0)).xyz;   // orthographic, w is 1
     ndc = ndc * 0.5 + 0.5;
     if (ndc.x < 0.0 || ndc.x > 1.0 ||
         ndc.y < 0.0 || ndc.y > 1.0 ||
         ndc.z < 0.0 || ndc.z > 1.0) {
         return 1.0;
     }
-    float closest_depth = texture(shadow_map, ndc.xy).r;
-    float current_depth = ndc.z;
-    float bias = 0.002;
-
-    return ((current_depth - bias) < closest_depth) ? 1.0 : 0.0;
+    // depth is linear here: 0.0003 is 0.05-0.1 units over a cascade's depth range
+    float bias = slope_bias(-sun_light.direction, 0.0003);
+    return pcf(shadow_map, vec3(ndc.xy, ndc.z - bias), float(cascade));
+}
+#else
+float shadow_scalar() {
+    vec4 lightSpacePos = light_proj_view_matrix * vec4(fragment_position, 1.0);
+    vec3 ndc = lightSpacePos.xyz / lightSpacePos.w;
+    ndc = ndc * 0.5 + 0.5;
+    if (ndc.x < 0.0 || ndc.x > 1.0 ||
+        ndc.y < 0.0 || ndc.y > 1.0 ||
+        ndc.z < 0.0 || ndc.z > 1.0) {
+        return 1.0;
+    }
+    float bias = slope_bias(normalize(sun_light.position - fragment_position), 0.0005);
+    return pcf(shadow_map, vec3(ndc.xy, ndc.z - bias));
 }
+#endif
 
 float spotlight_scalar() {
-    float theta = dot(normalize(fragment_position - light_position), light_direction);
-    if (theta > light_cutoff_inner) {
+    float theta = dot(normalize(fragment_position - sun_light.position), sun_light.direction);
+    if (theta > sun_light.cutoff_inner) {
         return 1.0;
-    } else if (theta > light_cutoff_outer) {
-        return (1.0 - cos(PI * (theta - light_cutoff_outer) / (light_cutoff_inner - light_cutoff_outer))) * 0.5;
+    } else if (theta > sun_light.cutoff_outer) {
+        return (1.0 - cos(PI * (theta - sun_light.cutoff_outer) / (sun_light.cutoff_inner - sun_light.cutoff_outer))) * 0.5;
     } else {
         return 0.0;
     }
@@ -93,7 +184,8 @@ float spotlight_scalar_custom(vec3 Lpos, vec3 Ldir, float innerCos, float outerC
     }
 }
 
-float shadow_scalar_custom(vec4 lightSpacePos, sampler2D shadowTex) {
+#ifndef NO_FLOODLIGHT
+float shadow_scalar_custom(vec4 lightSpacePos, float layer, vec3 lightPos) {
     vec3 ndc = lightSpacePos.xyz / lightSpacePos.w;
     ndc = ndc * 0.5 + 0.5;
     if (ndc.x < 0.0 || ndc.x > 1.0 ||
@@ -101,28 +193,29 @@ float shadow_scalar_custom(vec4 lightSpacePos, sampler2D shadowTex) {
         ndc.z < 0.0 || ndc.z > 1.0) {
         return 1.0;
     }
-    float closest_depth = texture(shadowTex, ndc.xy).r;
-    float current_depth = ndc.z;
-    float bias = 0.002;
-    return ((current_depth - bias) < closest_depth) ? 1.0 : 0.0;
+    float bias = slope_bias(normalize(lightPos - fragment_position), 0.0005);
+    return pcf(spot_shadow_maps, vec3(ndc.xy, ndc.z - bias), layer);
 }
+#endif
 
 void main()
 {
-    float lit = shadow_scalar() * spotlight_scalar();
+    float lit = sun_light.intensity * shadow_scalar() * spotlight_scalar();
 
     vec3 baseColor = texture(albedo_tex, vUV * uv_scale).rgb * object_color;
 
-    vec3 ambient  = ambient_color(light_color);
-    vec3 diffuse  = lit * diffuse_color(light_color, light_position);
-    vec3 specular = lit * specular_color(light_color, light_position);
+    vec3 ambient  = ambient_color(sun_light.color);
+    vec3 diffuse  = lit * diffuse_color(sun_light.color, sun_light.position);
+    vec3 specular = lit * specular_color(sun_light.color, sun_light.position);
+#ifndef NO_FLOODLIGHT
     float camSpot = spotlight_scalar_custom(
-    camLight_position, camLight_direction,
-    camLight_cutoff_inner, camLight_cutoff_outer);
-    float litCam = camSpot * shadow_scalar_custom(fragment_position_camLight_space, cam_shadow_map);
+    cam_light.position, cam_light.direction,
+    cam_light.cutoff_inner, cam_light.cutoff_outer);
+    float litCam = camSpot * shadow_scalar_custom(camLight_proj_view_matrix * vec4(fragment_position, 1.0), 0.0, cam_light.position);
 
-    diffuse  += litCam * camLight_intensity * diffuse_color(camLight_color, camLight_position);
-    specular += litCam * camLight_intensity * specular_color(camLight_color, camLight_position);
+    diffuse  += litCam * cam_light.intensity * diffuse_color(cam_light.color, cam_light.position);
+    specular += litCam * cam_light.intensity * specular_color(cam_light.color, cam_light.position);
+#endif
 
     vec3 color = (specular + diffuse + ambient) * baseColor;
     result = vec4(color, 1.0);
@@ -2,32 +2,61 @@
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_uv;     
+layout (location = 3) in mat4 instance_model;        // per instance, locations 3-6
+layout (location = 7) in float instance_prop_phase;  // per instance, radians
+layout (location = 9) in mat3 instance_normal;       // per instance, locations 9-11, normal matrix of instance_model
+
+// per-frame values, shared with every program (UniformBlocks.h)
+layout (std140) uniform FrameUniforms {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    mat4 light_proj_view_matrix;
+    mat4 camLight_proj_view_matrix;
+    vec4 view_position;          // xyz
+    mat4 sun_cascade_matrices[4];   // SUN_CASCADE_COUNT
+    vec4 sun_cascade_splits;     // view distance each cascade ends at
+};
 
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
-uniform mat4 light_proj_view_matrix;
-uniform mat4 camLight_proj_view_matrix;              
+uniform mat3 normal_matrix;  // transpose(inverse(mat3(model_matrix))), set with it
+uniform int instance_mode;   // 0: model_matrix, 1: instance_model, 2: propeller of instance_model
 
 
 out vec3 fragment_normal;
-out vec3 fragment_position;
-out vec4 fragment_position_light_space;
-out vec4 fragment_position_camLight_space; 
+out vec3 fragment_position;   // the fragment shader takes light space positions from this
 out vec2 vUV;                            
 
+// propeller relative to its plane (utils::SubmitPlane bounds it the same way):
+// translate(0, -15, 0.8) * rotateY(phase) * scale(1.3)
+mat4 propellerMatrix(float phase)
+{
+    float c = cos(phase) * 1.3;
+    float s = sin(phase) * 1.3;
+    return mat4(  c, 0.0,  -s, 0.0,
+                0.0, 1.3, 0.0, 0.0,
+                  s, 0.0,   c, 0.0,
+                0.0, -15.0, 0.8, 1.0);
+}
+
 void main()
 {
-    vec4 worldPos = model_matrix * vec4(in_position, 1.0);
+    mat4 model = model_matrix;
+    mat3 normalMatrix = normal_matrix;
+    if (instance_mode == 1) {
+        model = instance_model;
+        normalMatrix = instance_normal;
+    } else if (instance_mode == 2) {
+        // the propeller only rotates and scales evenly, so its upper 3x3
+        // turns normals too; the length is normalised away
+        mat4 propeller = propellerMatrix(instance_prop_phase);
+        model = instance_model * propeller;
+        normalMatrix = instance_normal * mat3(propeller);
+    }
+
+    vec4 worldPos = model * vec4(in_position, 1.0);
     fragment_position = worldPos.xyz;
-
-    // normal: use normal matrix
-    mat3 normalMatrix = mat3(transpose(inverse(model_matrix)));
     fragment_normal = normalize(normalMatrix * in_normal);
 
-    fragment_position_light_space = light_proj_view_matrix * worldPos;
-    fragment_position_camLight_space = camLight_proj_view_matrix * worldPos;
-
     vUV = in_uv;
 
     gl_Position = projection_matrix * view_matrix * worldPos;
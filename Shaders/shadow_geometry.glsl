@@ -0,0 +1,26 @@
+#version 330 core
+// Layered shadow pass: every triangle is projected into each depth layer
+// its instance's mask selects (RenderQueue::flushLayers), so one draw fills
+// all the layers instead of one draw per light.
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 24) out;   // 3 * MAX_SHADOW_LAYERS
+
+const int MAX_SHADOW_LAYERS = 8;   // as in UniformBlocks.h
+
+uniform mat4 layer_matrices[MAX_SHADOW_LAYERS];   // light projection * view per layer
+
+flat in uint vs_layers[];          // world positions arrive in gl_Position
+
+void main()
+{
+    uint layers = vs_layers[0];
+    for (int layer = 0; layer < MAX_SHADOW_LAYERS; ++layer) {
+        if ((layers & (1u << uint(layer))) == 0u) continue;
+        for (int v = 0; v < 3; ++v) {
+            gl_Layer = layer;
+            gl_Position = layer_matrices[layer] * gl_in[v].gl_Position;
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
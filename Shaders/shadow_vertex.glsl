@@ -1,10 +1,52 @@
 #version 330 core
 layout (location = 0) in vec3 position;
+layout (location = 3) in mat4 instance_model;        // per instance, locations 3-6
+layout (location = 7) in float instance_prop_phase;  // per instance, radians
+#ifdef LAYERED
+layout (location = 8) in uint instance_layers;       // per instance, bit i: layer i
 
-uniform mat4 transform_in_light_space;
+// LAYERED builds leave the world position in gl_Position and let
+// shadow_geometry.glsl project it once per layer
+flat out uint vs_layers;
+#endif
+
+// per-frame values, shared with every program (UniformBlocks.h)
+layout (std140) uniform FrameUniforms {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    mat4 light_proj_view_matrix;
+    mat4 camLight_proj_view_matrix;
+    vec4 view_position;          // xyz
+    mat4 sun_cascade_matrices[4];   // SUN_CASCADE_COUNT
+    vec4 sun_cascade_splits;     // view distance each cascade ends at
+};
+
+uniform mat4 model_matrix;
+uniform int shadow_light;    // 0: light_proj_view_matrix, 1: camLight_proj_view_matrix
+uniform int instance_mode;   // 0: model_matrix, 1: instance_model, 2: propeller of instance_model
+
+// propeller relative to its plane, same as scene_vertex.glsl
+mat4 propellerMatrix(float phase)
+{
+    float c = cos(phase) * 1.3;
+    float s = sin(phase) * 1.3;
+    return mat4(  c, 0.0,  -s, 0.0,
+                0.0, 1.3, 0.0, 0.0,
+                  s, 0.0,   c, 0.0,
+                0.0, -15.0, 0.8, 1.0);
+}
 
 void main()
 {
+    mat4 model = model_matrix;
+    if (instance_mode == 1) model = instance_model;
+    else if (instance_mode == 2) model = instance_model * propellerMatrix(instance_prop_phase);
 
-    gl_Position = transform_in_light_space * vec4(position, 1.0);
+#ifdef LAYERED
+    vs_layers = instance_layers;
+    gl_Position = model * vec4(position, 1.0);
+#else
+    mat4 light = shadow_light == 0 ? light_proj_view_matrix : camLight_proj_view_matrix;
+    gl_Position = light * model * vec4(position, 1.0);
+#endif
 }
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "UniformBlocks.h"
+
+// Cascaded shadow maps for a directional light. The camera frustum, out to
+// shadowDistance, is cut into SUN_CASCADE_COUNT slices, and each slice gets
+// its own orthographic light matrix and its own layer of the sun's depth
+// array, so the slices near the camera get far more texels per metre than
+// one map stretched over the whole scene.
+//
+// Each slice is wrapped in a bounding sphere, whose size doesn't change as
+// the camera turns, and the light matrix is snapped to whole texels. Moving
+// the camera then shifts the map in texel steps instead of resampling it
+// every frame, which is what makes plain fitted cascades shimmer.
+//
+// The sphere's centre is also snapped to a coarse world grid, so a
+// cascade's matrix only changes when the camera carries its slice into
+// another grid cell. The static casters' cache is keyed on that matrix
+// (RenderQueue::signature), so it survives ordinary camera moves and turns
+// rather than being rebaked every frame.
+class SunCascades {
+private:
+    glm::vec3 direction;       // light travel direction, normalised
+    float casterRange;         // how far behind a slice the light looks for casters
+    int mapSize;
+    float splits[SUN_CASCADE_COUNT + 1];   // view distances, splits[0] the near plane
+
+    static constexpr float GRID_FRACTION = 0.25f;   // centre grid cell, as a fraction of the slice radius
+
+public:
+    // lambda blends logarithmic (1) and even (0) split spacing
+    SunCascades(const glm::vec3& lightDirection, float nearPlane, float shadowDistance, int texSize,
+                float lambda = 0.8f, float casterRangeUnits = 150.f)
+        : direction(glm::normalize(lightDirection)), casterRange(casterRangeUnits), mapSize(texSize) {
+        splits[0] = nearPlane;
+        for (int i = 1; i <= SUN_CASCADE_COUNT; ++i) {
+            const float t = float(i) / SUN_CASCADE_COUNT;
+            const float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, t);
+            const float evenSplit = nearPlane + (shadowDistance - nearPlane) * t;
+            splits[i] = lambda * logSplit + (1.f - lambda) * evenSplit;
+        }
+    }
+
+    // view distance where the cascade ends
+    float splitFar(int cascade) const { return splits[cascade + 1]; }
+
+    // all the far distances, as FrameUniforms::sunCascadeSplits wants them
+    glm::vec4 splitFars() const {
+        glm::vec4 v(0.f);
+        for (int i = 0; i < SUN_CASCADE_COUNT && i < 4; ++i) v[i] = splitFar(i);
+        return v;
+    }
+
+    // The near cascades change every frame; far ones cover so much ground
+    // that every other (and every fourth) frame is enough. The offsets keep
+    // two far cascades from landing on the same frame.
+    static bool Due(int cascade, unsigned frame) {
+        const unsigned interval = cascade < 2 ? 1u : 1u << (cascade - 1);
+        return (frame + unsigned(cascade)) % interval == 0;
+    }
+
+    // light projection * view for one slice of the camera frustum
+    glm::mat4 fit(int cascade, const glm::vec3& cameraPosition, const glm::vec3& cameraForward,
+                  float fovY, float aspect) const {
+        using namespace glm;
+        const float n = splits[cascade], f = splits[cascade + 1];
+        // squared length of a corner ray per unit of depth
+        const float k2 = 1.f + std::pow(std::tan(fovY * 0.5f), 2.f) * (1.f + aspect * aspect);
+        // the slice's bounding sphere sits on the view axis; its size depends
+        // on the split distances and lens only, never on where the camera looks
+        const float centreDepth = std::min(f, 0.5f * (n + f) * k2);
+        const float farCorner = std::pow(f - centreDepth, 2.f) + (k2 - 1.f) * f * f;
+        const float nearCorner = std::pow(n - centreDepth, 2.f) + (k2 - 1.f) * n * n;
+        const float sliceRadius = std::ceil(std::sqrt(std::max(farCorner, nearCorner)) * 16.f) / 16.f;   // 1/16 steps
+        const vec3 sliceCentre = cameraPosition + normalize(cameraForward) * centreDepth;
+
+        // snap the centre to the grid and grow the sphere by the most the
+        // snap can move it (half a cell diagonal), so it still holds the slice
+        const float cell = sliceRadius * GRID_FRACTION;
+        const vec3 centre(std::floor(sliceCentre.x / cell + 0.5f) * cell,
+                          std::floor(sliceCentre.y / cell + 0.5f) * cell,
+                          std::floor(sliceCentre.z / cell + 0.5f) * cell);
+        const float radius = sliceRadius + cell * 0.8660254f;   // sqrt(3) / 2
+
+        const vec3 up = std::fabs(direction.y) > 0.99f ? vec3(0.f, 0.f, 1.f) : vec3(0.f, 1.f, 0.f);
+        const mat4 view = lookAt(centre - direction * (radius + casterRange), centre, up);
+        mat4 proj = ortho(-radius, radius, -radius, radius, 0.f, 2.f * radius + casterRange);
+
+        // snap the world origin to a texel so the map only ever moves in whole texels
+        const vec4 origin = proj * view * vec4(0.f, 0.f, 0.f, 1.f);
+        const float half = mapSize * 0.5f;
+        const float dx = (std::round(origin.x * half) - origin.x * half) / half;
+        const float dy = (std::round(origin.y * half) - origin.y * half) / half;
+        proj[3][0] += dx;
+        proj[3][1] += dy;
+        return proj * view;
+    }
+};
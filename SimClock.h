@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+
+// Accumulator-driven fixed-step clock. Each frame, advance() takes the real
+// frame time and returns how many fixed steps the simulation should run.
+// alpha() is how far the leftover time reaches into the next step, for
+// interpolating between the last two sim states when rendering.
+class SimClock {
+public:
+    // tick rates outside this are clamped: slower ticks step the fleet
+    // further than AirplaneFleet's kernel handles (MAX_POLY_STEP)
+    static constexpr float MIN_TICK_HZ = 1.f;
+    static constexpr float MAX_TICK_HZ = 10000.f;
+
+    static float ClampTickRate(float tickRateHz) {
+        if (!(tickRateHz >= MIN_TICK_HZ)) return MIN_TICK_HZ;   // NaN too
+        return std::min(tickRateHz, MAX_TICK_HZ);
+    }
+
+private:
+    double step;
+    int maxSteps;
+    double accumulator{0.0};
+    double dropped{0.0};   // time thrown away by the step cap
+
+public:
+    explicit SimClock(float tickRateHz, int maxStepsPerFrame = 5)
+        : step(1.0 / ClampTickRate(tickRateHz)), maxSteps(maxStepsPerFrame) {}
+
+    int advance(double frameDt) {
+        accumulator += std::max(frameDt, 0.0);
+        int steps = static_cast<int>(accumulator / step);
+        // cap the catch-up so a slow frame can't snowball into slower frames
+        if (steps > maxSteps) {
+            dropped += accumulator - maxSteps * step;
+            accumulator = maxSteps * step;
+            steps = maxSteps;
+        }
+        accumulator -= steps * step;
+        return steps;
+    }
+
+    void setTickRate(float tickRateHz) {
+        tickRateHz = ClampTickRate(tickRateHz);
+        accumulator *= (1.0 / tickRateHz) / step;
+        step = 1.0 / tickRateHz;
+    }
+
+    float stepSeconds() const { return static_cast<float>(step); }
+    float tickRate() const { return static_cast<float>(1.0 / step); }
+    float alpha() const { return static_cast<float>(accumulator / step); }
+    double droppedSeconds() const { return dropped; }
+};
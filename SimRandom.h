@@ -0,0 +1,172 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Simulation randomness. SimRng runs 8 interleaved xoshiro128** generators
+// (128 bytes of state) so a batch of 8 values comes out of one SIMD round.
+// The generator only needs 32-bit adds, shifts and xors, so AVX2, SSE2 and
+// the scalar fallback produce the same stream for the same seed. Single
+// draws and fill*() calls take values from that one stream in order.
+// Not thread-safe: give each thread or system its own SimRng.
+
+// splitmix64, used to expand seeds
+inline std::uint64_t SplitMix64(std::uint64_t& state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// independent seed for entity/stream id under a world seed
+inline std::uint64_t EntitySeed(std::uint64_t worldSeed, std::uint64_t entityId)
+{
+    std::uint64_t s = worldSeed ^ (entityId * 0xD1B54A32D192ED03ull);
+    SplitMix64(s);
+    return SplitMix64(s);
+}
+
+class SimRng {
+public:
+    static constexpr std::size_t LANES = 8;
+
+private:
+    alignas(32) std::uint32_t s[4][LANES];
+    alignas(32) std::uint32_t buf[LANES];
+    std::size_t bufPos = LANES;   // next unread value in buf
+
+    static std::uint32_t rotl(std::uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    // advances every lane once and writes one output per lane
+    void round(std::uint32_t* out) {
+#if defined(__AVX2__)
+        const __m256i s0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(s[0]));
+        __m256i s1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(s[1]));
+        __m256i s2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(s[2]));
+        __m256i s3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(s[3]));
+        const __m256i x5 = _mm256_add_epi32(_mm256_slli_epi32(s1, 2), s1);
+        const __m256i r7 = _mm256_or_si256(_mm256_slli_epi32(x5, 7), _mm256_srli_epi32(x5, 25));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_add_epi32(_mm256_slli_epi32(r7, 3), r7));
+        const __m256i t = _mm256_slli_epi32(s1, 9);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        const __m256i n0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s[0]), n0);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s[1]), s1);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s[2]), s2);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s[3]), s3);
+#elif defined(__SSE2__)
+        for (std::size_t l = 0; l < LANES; l += 4) {
+            const __m128i s0 = _mm_load_si128(reinterpret_cast<const __m128i*>(s[0] + l));
+            __m128i s1 = _mm_load_si128(reinterpret_cast<const __m128i*>(s[1] + l));
+            __m128i s2 = _mm_load_si128(reinterpret_cast<const __m128i*>(s[2] + l));
+            __m128i s3 = _mm_load_si128(reinterpret_cast<const __m128i*>(s[3] + l));
+            const __m128i x5 = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+            const __m128i r7 = _mm_or_si128(_mm_slli_epi32(x5, 7), _mm_srli_epi32(x5, 25));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + l), _mm_add_epi32(_mm_slli_epi32(r7, 3), r7));
+            const __m128i t = _mm_slli_epi32(s1, 9);
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            const __m128i n0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+            _mm_store_si128(reinterpret_cast<__m128i*>(s[0] + l), n0);
+            _mm_store_si128(reinterpret_cast<__m128i*>(s[1] + l), s1);
+            _mm_store_si128(reinterpret_cast<__m128i*>(s[2] + l), s2);
+            _mm_store_si128(reinterpret_cast<__m128i*>(s[3] + l), s3);
+        }
+#else
+        for (std::size_t l = 0; l < LANES; ++l) {
+            out[l] = rotl(s[1][l] * 5, 7) * 9;
+            const std::uint32_t t = s[1][l] << 9;
+            s[2][l] ^= s[0][l];
+            s[3][l] ^= s[1][l];
+            s[1][l] ^= s[2][l];
+            s[0][l] ^= s[3][l];
+            s[2][l] ^= t;
+            s[3][l] = rotl(s[3][l], 11);
+        }
+#endif
+    }
+
+    // raw values -> out[0..n) through convert, in stream order
+    template <typename T, typename Convert>
+    void fill(T* out, std::size_t n, Convert convert) {
+        std::size_t k = 0;
+        while (k < n && bufPos < LANES) out[k++] = convert(buf[bufPos++]);
+        alignas(32) std::uint32_t raw[LANES];
+        for (; k + LANES <= n; k += LANES) {
+            round(raw);
+            for (std::size_t l = 0; l < LANES; ++l) out[k + l] = convert(raw[l]);
+        }
+        if (k < n) {
+            round(buf);
+            bufPos = 0;
+            while (k < n) out[k++] = convert(buf[bufPos++]);
+        }
+    }
+
+    // top 24 bits -> [0, 1), exact in float
+    static float toUniform(std::uint32_t x) { return static_cast<float>(x >> 8) * (1.f / 16777216.f); }
+    // top 16 bits scaled to {0, 1, 2}, then shifted to -1, 0, 1
+    static float toPick(std::uint32_t x) { return static_cast<float>(static_cast<int>(((x >> 16) * 3u) >> 16) - 1); }
+
+public:
+    explicit SimRng(std::uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(std::uint64_t seed) {
+        std::uint64_t sm = seed;
+        for (std::size_t l = 0; l < LANES; ++l) {
+            const std::uint64_t a = SplitMix64(sm), b = SplitMix64(sm);
+            s[0][l] = static_cast<std::uint32_t>(a);
+            s[1][l] = static_cast<std::uint32_t>(a >> 32);
+            s[2][l] = static_cast<std::uint32_t>(b);
+            s[3][l] = static_cast<std::uint32_t>(b >> 32);
+            if ((s[0][l] | s[1][l] | s[2][l] | s[3][l]) == 0) s[0][l] = 1;   // all-zero state is a fixed point
+        }
+        bufPos = LANES;
+    }
+
+    std::uint32_t nextU32() {
+        if (bufPos == LANES) { round(buf); bufPos = 0; }
+        return buf[bufPos++];
+    }
+    float uniform() { return toUniform(nextU32()); }          // [0, 1)
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    float pick() { return toPick(nextU32()); }               // -1, 0 or 1
+
+    void fillU32(std::uint32_t* out, std::size_t n) { fill(out, n, [](std::uint32_t x) { return x; }); }
+    void fillUniform(float* out, std::size_t n) { fill(out, n, toUniform); }
+    void fillPicks(float* out, std::size_t n) { fill(out, n, toPick); }
+};
+
+// World seed for generators that aren't handed one explicitly. Random per
+// run unless SetSimSeed() is called before the first draw.
+inline std::atomic<std::uint64_t>& SimSeedStorage()
+{
+    static std::atomic<std::uint64_t> seed{ (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}() };
+    return seed;
+}
+inline std::uint64_t SimSeed() { return SimSeedStorage().load(std::memory_order_relaxed); }
+inline void SetSimSeed(std::uint64_t seed) { SimSeedStorage().store(seed, std::memory_order_relaxed); }
+
+// per-thread generator, seeded from SimSeed() and the order threads first
+// draw in; systems that must replay exactly should own a SimRng instead
+inline SimRng& ThreadRng()
+{
+    static std::atomic<std::uint64_t> nextStream{0};
+    static thread_local SimRng rng(EntitySeed(SimSeed(), nextStream.fetch_add(1, std::memory_order_relaxed)));
+    return rng;
+}
+
+inline float randomPick() { return ThreadRng().pick(); }   // -1, 0, 1
@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "AirplaneFleet.h"
+#include "Bullet.h"
+#include "BulletPool.h"
+#include "Collision.h"
+#include "EventQueue.h"
+#include "JobSystem.h"
+#include "SimRandom.h"
+#include "StaticWorld.h"
+
+// Everything the fixed-step simulation owns. step() advances planes and
+// bullets and runs the collision phase; with a JobSystem the integration,
+// the bullet sweeps and hit emission are spread over all workers:
+//
+//   planes.integrateBlocks ──> grid.build ─────────────────────┐
+//   bullets.integrateRange + collideWithWorld ──> removeDead ──┴─> SweepBulletRange ──> emitHits
+//
+// Bullets that hit the static world are culled before the plane sweep.
+// planes.finishStep() runs on the calling thread alongside grid.build; it
+// only touches turn directions and the slot free list, which build never reads.
+//
+// Stages report spawns, hits and expiries to a lock-free event queue rather
+// than acting on them. The queue is drained once at the end of the step:
+// hits are applied to the pools there, and every event is appended to
+// frameEvents() for scoring, effects and draw lists to read once per frame.
+class SimWorld {
+private:
+    static constexpr std::size_t PLANE_BLOCK_GRAIN = 32;   // SIMD blocks per job
+    static constexpr std::size_t BULLET_GRAIN = 1024;
+    static constexpr std::size_t HIT_GRAIN = 256;
+    static constexpr std::uint64_t PLANE_STREAM = 1;
+
+    JobSystem* jobs;
+    JobCounter planesDone, bulletsDone, gridDone, sweepDone, hitsDone;
+    EventQueue events;
+    std::vector<SimEvent> frameLog;
+    std::vector<HitPair> hits;   // scratch: this step's hits by pool index, for applyEvents
+
+public:
+    AirplaneFleet planes;
+    BulletPool bullets;
+    PlaneGrid planeGrid;
+    StaticWorld staticWorld;   // fill and build() at load, before the first step
+
+    // the queue holds one step's worth: every plane spawning, being hit and
+    // expiring, and every bullet spawning and ending
+    SimWorld(std::uint32_t maxPlanes, std::size_t maxBullets, JobSystem* jobSystem = nullptr,
+             std::uint64_t seed = SimSeed())
+        : jobs(jobSystem), events(3 * std::size_t(maxPlanes) + 2 * maxBullets),
+          planes(maxPlanes, EntitySeed(seed, PLANE_STREAM)), bullets(maxBullets), planeGrid(maxPlanes)
+    {
+        frameLog.reserve(events.capacity());
+        hits.reserve(maxPlanes);
+    }
+
+    // returns an invalid handle when the fleet is full
+    EntityHandle spawnPlane(const glm::vec3& pos) {
+        const EntityHandle h = planes.spawn(pos);
+        if (h.valid()) events.push(SimEvent{ SimEvent::PLANE_SPAWNED, h, 0, pos });
+        return h;
+    }
+
+    // drops the shot and returns false when the pool is full
+    bool spawnBullet(const Bullet& b) {
+        if (!bullets.spawn(b)) return false;
+        events.push(SimEvent{ SimEvent::BULLET_SPAWNED, EntityHandle{}, bullets.id(bullets.size() - 1), b.position() });
+        return true;
+    }
+
+    void step(float dt) {
+        if (jobs) stepParallel(dt);
+        else {
+            planes.update(dt, &events);
+            bullets.integrateRange(dt, 0, bullets.size(), &events);
+            bullets.collideWithWorld(staticWorld, 0, bullets.size(), &events);
+            bullets.removeDead();
+            planeGrid.build(planes);
+            SweepBulletRange(bullets, planeGrid, 0, bullets.size());
+            planeGrid.emitHits(planes, bullets, events, 0, planes.size());
+        }
+        applyEvents();
+    }
+
+    // events of every step since the last clear, step by step, each step
+    // ordered by type and then entity
+    const std::vector<SimEvent>& frameEvents() const { return frameLog; }
+    void clearFrameEvents() { frameLog.clear(); }
+    std::uint64_t droppedEvents() const { return events.dropped(); }
+
+private:
+    // The single consumer: logs the step's events and applies hits to the
+    // pools. Producers ran in parallel, so the batch is put in a fixed order
+    // first; slots are then released in the same order on every run, which
+    // keeps later spawns, and the whole sim, independent of thread timing.
+    // Events name bullets by id, since removeDead has moved them since
+    // some were pushed; the hit bullets are killed by index from the grid,
+    // which indexes the pool as it is now.
+    void applyEvents() {
+        const std::size_t first = frameLog.size();
+        events.drain([&](const SimEvent& e) { frameLog.push_back(e); });
+        std::sort(frameLog.begin() + first, frameLog.end(), [](const SimEvent& a, const SimEvent& b) {
+            return std::tie(a.type, a.plane.index, a.bullet) < std::tie(b.type, b.plane.index, b.bullet);
+        });
+        for (std::size_t i = first; i < frameLog.size(); ++i) {
+            const SimEvent& e = frameLog[i];
+            if (e.type != SimEvent::PLANE_HIT) continue;
+            planes.kill(e.plane);
+        }
+        hits.clear();
+        planeGrid.collectHits(hits);
+        for (const HitPair& h : hits) bullets.kill(h.bullet);
+    }
+
+    void stepParallel(float dt) {
+        auto integratePlanes = [&](std::size_t lo, std::size_t hi) { planes.integrateBlocks(dt, lo, hi); };
+        auto integrateBullets = [&](std::size_t lo, std::size_t hi) {
+            bullets.integrateRange(dt, lo, hi, &events);
+            bullets.collideWithWorld(staticWorld, lo, hi, &events);
+        };
+        auto buildGrid = [&]() { planeGrid.build(planes); };
+        auto sweep = [&](std::size_t lo, std::size_t hi) { SweepBulletRange(bullets, planeGrid, lo, hi); };
+        auto emit = [&](std::size_t lo, std::size_t hi) { planeGrid.emitHits(planes, bullets, events, lo, hi); };
+
+        jobs->parallelFor(0, planes.blockCount(), PLANE_BLOCK_GRAIN, integratePlanes, planesDone);
+        jobs->parallelFor(0, bullets.size(), BULLET_GRAIN, integrateBullets, bulletsDone);
+        jobs->run(buildGrid, gridDone, &planesDone);
+
+        jobs->wait(planesDone);
+        planes.finishStep(&events);
+        jobs->wait(bulletsDone);
+        bullets.removeDead();
+
+        jobs->parallelFor(0, bullets.size(), BULLET_GRAIN, sweep, sweepDone, &gridDone);
+        jobs->wait(gridDone);
+        jobs->wait(sweepDone);
+        jobs->parallelFor(0, planes.size(), HIT_GRAIN, emit, hitsDone);
+        jobs->wait(hitsDone);
+    }
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Static collision geometry for bullets. Each piece of scenery is a box
+// leaf: the mesh's local bounds plus the model matrix it is drawn with, so
+// rotated and scaled props collide with the shape the player sees. Leaves
+// are kept in an AABB tree built once at load; segments are tested against
+// the tree and, at the leaves, in the box's own space, where the oriented
+// box is an axis-aligned one again. Affine maps keep the segment parameter,
+// so the local hit fraction is the world one.
+class StaticWorld {
+private:
+    struct Leaf {
+        glm::mat4 toLocal;            // inverse model matrix
+        glm::vec3 localMin, localMax;
+        glm::vec3 worldMin, worldMax; // bounds of the transformed box
+    };
+    struct Node {
+        glm::vec3 min, max;
+        std::uint32_t first, count;   // leaf range for leaves, count == 0 for inner nodes
+        std::uint32_t right;          // inner nodes: left child is the next node
+    };
+    static constexpr std::uint32_t LEAF_SIZE = 2;
+    static constexpr int MAX_DEPTH = 64;
+
+    std::vector<Leaf> leaves;
+    std::vector<Node> nodes;
+
+    // slab test of the segment from o along d (t in [0, tMax]) against a box
+    static bool segmentBox(const glm::vec3& o, const glm::vec3& d, const glm::vec3& lo,
+                           const glm::vec3& hi, float tMax, float& tHit) {
+        float t0 = 0.f, t1 = tMax;
+        for (int a = 0; a < 3; ++a) {
+            if (std::abs(d[a]) < 1e-12f) {
+                if (o[a] < lo[a] || o[a] > hi[a]) return false;
+                continue;
+            }
+            const float inv = 1.f / d[a];
+            float tn = (lo[a] - o[a]) * inv, tf = (hi[a] - o[a]) * inv;
+            if (tn > tf) std::swap(tn, tf);
+            t0 = std::max(t0, tn);
+            t1 = std::min(t1, tf);
+            if (t0 > t1) return false;
+        }
+        tHit = t0;
+        return true;
+    }
+
+    std::uint32_t buildNode(std::uint32_t first, std::uint32_t count, int depth) {
+        const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(Node{});
+        glm::vec3 lo(1e30f), hi(-1e30f), cLo(1e30f), cHi(-1e30f);
+        for (std::uint32_t i = first; i < first + count; ++i) {
+            lo = glm::min(lo, leaves[i].worldMin);
+            hi = glm::max(hi, leaves[i].worldMax);
+            const glm::vec3 c = 0.5f * (leaves[i].worldMin + leaves[i].worldMax);
+            cLo = glm::min(cLo, c);
+            cHi = glm::max(cHi, c);
+        }
+        nodes[index].min = lo;
+        nodes[index].max = hi;
+        if (count <= LEAF_SIZE || depth >= MAX_DEPTH) {
+            nodes[index].first = first;
+            nodes[index].count = count;
+            return index;
+        }
+        // median split along the widest spread of box centres
+        const glm::vec3 ext = cHi - cLo;
+        const int axis = (ext.x >= ext.y && ext.x >= ext.z) ? 0 : (ext.y >= ext.z ? 1 : 2);
+        const std::uint32_t mid = first + count / 2;
+        std::nth_element(leaves.begin() + first, leaves.begin() + mid, leaves.begin() + first + count,
+                         [axis](const Leaf& a, const Leaf& b) {
+                             return a.worldMin[axis] + a.worldMax[axis] < b.worldMin[axis] + b.worldMax[axis];
+                         });
+        buildNode(first, mid - first, depth + 1);
+        const std::uint32_t right = buildNode(mid, first + count - mid, depth + 1);
+        nodes[index].first = first;
+        nodes[index].count = 0;
+        nodes[index].right = right;
+        return index;
+    }
+
+public:
+    // box [localMin, localMax] in model space, placed by model
+    void add(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax) {
+        Leaf l;
+        l.toLocal = glm::inverse(model);
+        l.localMin = localMin;
+        l.localMax = localMax;
+        l.worldMin = glm::vec3(1e30f);
+        l.worldMax = glm::vec3(-1e30f);
+        for (int c = 0; c < 8; ++c) {
+            const glm::vec3 corner((c & 1) ? localMax.x : localMin.x,
+                                   (c & 2) ? localMax.y : localMin.y,
+                                   (c & 4) ? localMax.z : localMin.z);
+            const glm::vec3 w = glm::vec3(model * glm::vec4(corner, 1.f));
+            l.worldMin = glm::min(l.worldMin, w);
+            l.worldMax = glm::max(l.worldMax, w);
+        }
+        leaves.push_back(l);
+    }
+
+    // call once after the last add()
+    void build() {
+        nodes.clear();
+        if (!leaves.empty()) buildNode(0, static_cast<std::uint32_t>(leaves.size()), 0);
+    }
+
+    bool empty() const { return nodes.empty(); }
+
+    // earliest hit of the segment a -> b, as a fraction of its length
+    bool segmentHit(const glm::vec3& a, const glm::vec3& b, float& toi) const {
+        if (nodes.empty()) return false;
+        const glm::vec3 d = b - a;
+        float best = 1.f;
+        bool hit = false;
+        std::uint32_t stack[MAX_DEPTH + 1];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& n = nodes[stack[--top]];
+            float t;
+            if (!segmentBox(a, d, n.min, n.max, best, t)) continue;
+            if (n.count == 0) {
+                stack[top++] = n.right;
+                stack[top++] = static_cast<std::uint32_t>(&n - nodes.data()) + 1;
+                continue;
+            }
+            for (std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                const Leaf& l = leaves[i];
+                const glm::vec3 la = glm::vec3(l.toLocal * glm::vec4(a, 1.f));
+                const glm::vec3 ld = glm::vec3(l.toLocal * glm::vec4(d, 0.f));
+                if (segmentBox(la, ld, l.localMin, l.localMax, best, t)) {
+                    best = t;
+                    hit = true;
+                }
+            }
+        }
+        if (hit) toi = best;
+        return hit;
+    }
+
+    // Batched query over n segments from[i] -> to[i]: clears alive[i] for
+    // every segment that touches the world and calls onHit(i, toi) for it.
+    // Segments already dead are skipped, as are ones that miss the root bounds.
+    template <typename OnHit>
+    void cullSegments(const glm::vec3* from, const glm::vec3* to, std::uint8_t* alive, std::size_t n,
+                      OnHit&& onHit) const {
+        if (nodes.empty()) return;
+        const glm::vec3 lo = nodes[0].min, hi = nodes[0].max;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!alive[i]) continue;
+            // both ends on the outside of one face: cannot touch anything
+            const glm::vec3 a = from[i], b = to[i];
+            if ((a.x < lo.x && b.x < lo.x) || (a.x > hi.x && b.x > hi.x) ||
+                (a.y < lo.y && b.y < lo.y) || (a.y > hi.y && b.y > hi.y) ||
+                (a.z < lo.z && b.z < lo.z) || (a.z > hi.z && b.z > hi.z)) continue;
+            float toi;
+            if (!segmentHit(a, b, toi)) continue;
+            alive[i] = 0;
+            onHit(i, toi);
+        }
+    }
+
+    void cullSegments(const glm::vec3* from, const glm::vec3* to, std::uint8_t* alive, std::size_t n) const {
+        cullSegments(from, to, alive, n, [](std::size_t, float) {});
+    }
+};
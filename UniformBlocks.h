@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Uniform blocks shared by every program. Each has a fixed binding point;
+// BindUniformBlocks() attaches a freshly linked program's blocks to them,
+// and one UniformBuffer per block is updated once a frame, however many
+// programs read it. The structs mirror the std140 layout of the blocks
+// declared in Shaders/*.glsl, so keep the two in step.
+constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+constexpr GLuint LIGHT_UNIFORMS_BINDING = 1;
+
+// slices of the sun's cascaded shadow map (ShadowCascades.h); the blocks in
+// Shaders/*.glsl size their arrays with the same number
+constexpr int SUN_CASCADE_COUNT = 4;
+
+// layers one layered shadow pass can fill (Shaders/shadow_geometry.glsl)
+constexpr int MAX_SHADOW_LAYERS = 8;
+
+// which of the FrameUniforms light matrices the non-layered shadow program renders with
+enum ShadowLight { SHADOW_SUN = 0, SHADOW_FLOODLIGHT = 1 };
+
+struct FrameUniforms {
+    glm::mat4 view{1.f};               // view_matrix
+    glm::mat4 projection{1.f};         // projection_matrix
+    glm::mat4 lightProjView{1.f};      // light_proj_view_matrix
+    glm::mat4 camLightProjView{1.f};   // camLight_proj_view_matrix
+    glm::vec4 viewPosition{0.f};       // view_position, w unused
+    glm::mat4 sunCascades[SUN_CASCADE_COUNT];   // sun_cascade_matrices
+    glm::vec4 sunCascadeSplits{0.f};   // sun_cascade_splits, view distance each cascade ends at
+};
+static_assert(sizeof(FrameUniforms) == 4 * 64 + 16 + SUN_CASCADE_COUNT * 64 + 16,
+              "FrameUniforms must match the std140 block");
+
+// a float after each vec3 fills the vec3's 16-byte slot, as std140 allows
+struct SpotLight {
+    glm::vec3 position{0.f};
+    float intensity = 0.f;           // 0 switches the light off
+    glm::vec3 direction{0.f, -1.f, 0.f};
+    float cutoffInner = 1.f;         // cosines of the cone half-angles
+    glm::vec3 color{1.f};
+    float cutoffOuter = 1.f;
+};
+static_assert(sizeof(SpotLight) == 48, "SpotLight must match the std140 struct");
+
+struct LightUniforms {
+    SpotLight sun;          // sun_light
+    SpotLight floodlight;   // cam_light
+};
+static_assert(sizeof(LightUniforms) == 96, "LightUniforms must match the std140 block");
+
+// binds whichever of the shared blocks the program declares
+inline void BindUniformBlocks(GLuint program)
+{
+    const GLuint frame = glGetUniformBlockIndex(program, "FrameUniforms");
+    if (frame != GL_INVALID_INDEX) glUniformBlockBinding(program, frame, FRAME_UNIFORMS_BINDING);
+    const GLuint light = glGetUniformBlockIndex(program, "LightUniforms");
+    if (light != GL_INVALID_INDEX) glUniformBlockBinding(program, light, LIGHT_UNIFORMS_BINDING);
+}
+
+// A uniform buffer object attached to one binding point for its lifetime.
+class UniformBuffer {
+private:
+    GLuint ubo = 0;
+    GLsizeiptr bytes = 0;
+
+public:
+    UniformBuffer(GLuint binding, GLsizeiptr size) : bytes(size) {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // replaces the whole block; orphans first so the driver doesn't wait on
+    // draws still reading last frame's values
+    template <typename T>
+    void update(const T& data) {
+        static_assert(sizeof(T) % 16 == 0, "std140 blocks are a multiple of 16 bytes");
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    }
+
+    GLuint id() const { return ubo; }
+};
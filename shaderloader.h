@@ -1,80 +1,69 @@
 #include <stdio.h>
 #include <string>
+#include <utility>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 using namespace std;
 
-int loadSHADER(string vertex_file_path, string fragment_file_path) {
+// defines, e.g. "#define NO_FLOODLIGHT\n", go in after each stage's #version line
+inline void insertDefines(std::string& code, const std::string& defines) {
+	if (defines.empty()) return;
+	size_t at = code.find("#version");
+	at = (at == std::string::npos) ? 0 : code.find('\n', at) + 1;
+	code.insert(at, defines);
+}
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if (VertexShaderStream.is_open()) {
-		std::stringstream sstr;
-		sstr << VertexShaderStream.rdbuf();
-		VertexShaderCode = sstr.str();
-		VertexShaderStream.close();
-	}
-	else {
-		cout<<"Impossible to open. Are you in the right directory ? Don't forget to read the FAQ !\n"<< vertex_file_path;
+// reads, compiles and logs one stage; 0 when the file can't be opened or doesn't compile
+inline GLuint compileShaderFile(GLenum type, const string& file_path, const string& defines) {
+	std::string ShaderCode;
+	std::ifstream ShaderStream(file_path, std::ios::in);
+	if (!ShaderStream.is_open()) {
+		cout<<"Impossible to open. Are you in the right directory ? Don't forget to read the FAQ !\n"<< file_path;
 		getchar();
 		return 0;
 	}
+	std::stringstream sstr;
+	sstr << ShaderStream.rdbuf();
+	ShaderCode = sstr.str();
+	ShaderStream.close();
+	insertDefines(ShaderCode, defines);
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if (FragmentShaderStream.is_open()) {
-		std::stringstream sstr;
-		sstr << FragmentShaderStream.rdbuf();
-		FragmentShaderCode = sstr.str();
-		FragmentShaderStream.close();
-	}
-
+	GLuint ShaderID = glCreateShader(type);
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
-	// Compile Vertex Shader
-	cout << "Compiling shader : " << vertex_file_path << endl;
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
-	glCompileShader(VertexShaderID);
+	// Compile Shader
+	cout << "Compiling shader : " << file_path << endl;
+	char const * SourcePointer = ShaderCode.c_str();
+	glShaderSource(ShaderID, 1, &SourcePointer, NULL);
+	glCompileShader(ShaderID);
 
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	// Check Shader
+	glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
+	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if (InfoLogLength > 0) {
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength + 1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("%s\n", &VertexShaderErrorMessage[0]);
+		std::vector<char> ShaderErrorMessage(InfoLogLength + 1);
+		glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		printf("%s\n", &ShaderErrorMessage[0]);
 	}
-
-	// Compile Fragment Shader
-	cout << "Compiling shader : " << fragment_file_path << endl;
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
-	glCompileShader(FragmentShaderID);
-
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if (InfoLogLength > 0) {
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength + 1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("%s\n", &FragmentShaderErrorMessage[0]);
+	if (Result != GL_TRUE) {
+		glDeleteShader(ShaderID);
+		return 0;
 	}
+	return ShaderID;
+}
+
+// links the stages into a program and deletes them; 0 when linking fails
+inline GLuint linkShaders(const std::vector<GLuint>& ShaderIDs) {
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
 
 	// Link the program
 	printf("Linking program\n");
 	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
+	for (GLuint ShaderID : ShaderIDs) glAttachShader(ProgramID, ShaderID);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -86,11 +75,39 @@ int loadSHADER(string vertex_file_path, string fragment_file_path) {
 		printf("%s\n", &ProgramErrorMessage[0]);
 	}
 
-	glDetachShader(ProgramID, VertexShaderID);
-	glDetachShader(ProgramID, FragmentShaderID);
+	for (GLuint ShaderID : ShaderIDs) {
+		glDetachShader(ProgramID, ShaderID);
+		glDeleteShader(ShaderID);
+	}
+	if (Result != GL_TRUE) {
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
+
+// compiles every stage and links them; if any stage fails, the ones already
+// compiled are deleted and 0 is returned
+inline GLuint loadStages(const std::vector<std::pair<GLenum, string>>& stages, const string& defines) {
+	std::vector<GLuint> ShaderIDs;
+	for (const auto& stage : stages) {
+		GLuint ShaderID = compileShaderFile(stage.first, stage.second, defines);
+		if (ShaderID == 0) {
+			for (GLuint compiled : ShaderIDs) glDeleteShader(compiled);
+			return 0;
+		}
+		ShaderIDs.push_back(ShaderID);
+	}
+	return linkShaders(ShaderIDs);
+}
 
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
+inline int loadSHADER(string vertex_file_path, string fragment_file_path, const string& defines = "") {
+	return loadStages({ { GL_VERTEX_SHADER, vertex_file_path }, { GL_FRAGMENT_SHADER, fragment_file_path } }, defines);
+}
 
-	return ProgramID;
-}
\ No newline at end of file
+// the same with a geometry stage between the two
+inline int loadSHADERWithGeometry(string vertex_file_path, string geometry_file_path, string fragment_file_path,
+                                  const string& defines = "") {
+	return loadStages({ { GL_VERTEX_SHADER, vertex_file_path }, { GL_GEOMETRY_SHADER, geometry_file_path },
+	                    { GL_FRAGMENT_SHADER, fragment_file_path } }, defines);
+}
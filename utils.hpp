@@ -1,4 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -8,29 +12,39 @@
 
 #include "OBJloader.h"
 #include "OBJloaderV3.h"
-#include "Airplane.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "SceneMath.hpp"
+#include "ShaderProgram.h"
+#include "UniformBlocks.h"
 
 namespace utils {
 
 
+ // Uniform uploads go through the program's ShaderProgram cache: locations
+ // are looked up once and unchanged values aren't sent again.
+ void UseProgram(GLuint shader) {
+  ShaderProgram::Use(shader);
+}
+
  void SetUniformMat4(GLuint shader, const char* name, const glm::mat4& m) {
-  glUseProgram(shader);
-  glUniformMatrix4fv(glGetUniformLocation(shader, name), 1, GL_FALSE, &m[0][0]);
+  ShaderProgram::Get(shader).set(name, m);
 }
 
  void SetUniformVec3(GLuint shader, const char* name, const glm::vec3& v) {
-  glUseProgram(shader);
-  glUniform3fv(glGetUniformLocation(shader, name), 1, &v[0]);
+  ShaderProgram::Get(shader).set(name, v);
+}
+
+ void SetUniformVec2(GLuint shader, const char* name, const glm::vec2& v) {
+  ShaderProgram::Get(shader).set(name, v);
 }
 
  void SetUniform1f(GLuint shader, const char* name, float v) {
-  glUseProgram(shader);
-  glUniform1f(glGetUniformLocation(shader, name), v);
+  ShaderProgram::Get(shader).set(name, v);
 }
 
  void SetUniform1i(GLuint shader, const char* name, int v) {
-  glUseProgram(shader);
-  glUniform1i(glGetUniformLocation(shader, name), v);
+  ShaderProgram::Get(shader).set(name, v);
 }
 
 
@@ -38,6 +52,9 @@ struct Mesh {
   GLuint vao = 0;
   int    vertices = 0;   // for glDrawArrays
   GLuint texture = 0;    
+  glm::vec3 localMin{0.f}, localMax{0.f};   // model-space bounds of the vertices
+  glm::vec3 sphereCenter{0.f};              // model-space bounding sphere, centred on the box
+  float sphereRadius = 0.f;
 };
 
 struct PlaneMeshes {
@@ -55,7 +72,7 @@ struct PlaneMeshes {
 
   Mesh m;
   glGenVertexArrays(1, &m.vao);
-  glBindVertexArray(m.vao);
+  GLState::BindVertexArray(m.vao);
 
   GLuint vboV, vboN, vboUV;
   glGenBuffers(1, &vboV);
@@ -76,8 +93,18 @@ struct PlaneMeshes {
   glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
   glEnableVertexAttribArray(2);
 
-  glBindVertexArray(0);
+  GLState::BindVertexArray(0);
   m.vertices = static_cast<int>(glmVertices.size());
+  if (!glmVertices.empty()) {
+    m.localMin = m.localMax = glmVertices[0];
+    for (const glm::vec3& v : glmVertices) {
+      m.localMin = glm::min(m.localMin, v);
+      m.localMax = glm::max(m.localMax, v);
+    }
+    m.sphereCenter = 0.5f * (m.localMin + m.localMax);
+    for (const glm::vec3& v : glmVertices)
+      m.sphereRadius = std::max(m.sphereRadius, glm::distance(v, m.sphereCenter));
+  }
   return m;
 }
 
@@ -92,11 +119,14 @@ DepthMap CreateDepthMap(GLsizei texSize) {
   DepthMap d; d.size = texSize;
 
   glGenTextures(1, &d.texture);
-  glBindTexture(GL_TEXTURE_2D, d.texture);
+  GLState::BindTexture(0, GL_TEXTURE_2D, d.texture);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, texSize, texSize, 0,
                GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  // sampled as sampler2DShadow: linear filtering makes each lookup a 2x2 comparison
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
   // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
@@ -106,227 +136,181 @@ DepthMap CreateDepthMap(GLsizei texSize) {
   
 
   glGenFramebuffers(1, &d.fbo);
-  glBindFramebuffer(GL_FRAMEBUFFER, d.fbo);
+  GLState::BindFramebuffer(d.fbo);
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, d.texture, 0);
   glDrawBuffer(GL_NONE);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glReadBuffer(GL_NONE);   // depth only, or it isn't complete as a blit source
+  GLState::BindFramebuffer(0);
   return d;
 }
 
-void BindShadowMap(GLuint depthTex, GLuint depthCamTex) {
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, depthTex);
-  glActiveTexture(GL_TEXTURE2);
-  glBindTexture(GL_TEXTURE_2D, depthCamTex);
-}
-
-
-GLuint LoadTexture2D(const std::string& path);
-
+// a depth texture array, e.g. one layer per shadow cascade or spotlight, with
+// a framebuffer per layer and one with every layer attached for layered passes
+struct DepthMapArray {
+  GLuint texture = 0;
+  std::vector<GLuint> fbos;
+  GLuint layeredFbo = 0;
+  GLsizei size = 0;
+};
 
+DepthMapArray CreateDepthMapArray(GLsizei texSize, int layers) {
+  DepthMapArray d; d.size = texSize;
 
-// drawing helpers
-glm::mat4 BuildPlaneBaseModel(const Airplane& p) {
-  using namespace glm;
-  const mat4 T   = translate(mat4(1.f), p.position());
-  const mat4 Y   = p.velocityYawMatrix();
-  const mat4 Br  = rotate(mat4(1.f), radians(p.bankRollDeg()), vec3(0,0,1));
-  const mat4 Fix = rotate(mat4(1.f), radians(-90.f), vec3(1,0,0)); // model axis fix
-  const mat4 S   = scale(mat4(1.f), vec3(0.2f));
-  return T * Y * Br * Fix * S;
+  glGenTextures(1, &d.texture);
+  GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, d.texture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, texSize, texSize, layers, 0,
+               GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);   // as CreateDepthMap
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  float border[4] = {1,1,1,1};
+  glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+
+  d.fbos.resize(layers);
+  glGenFramebuffers(layers, d.fbos.data());
+  for (int i = 0; i < layers; ++i) {
+    GLState::BindFramebuffer(d.fbos[i]);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.texture, 0, i);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
+  glGenFramebuffers(1, &d.layeredFbo);
+  GLState::BindFramebuffer(d.layeredFbo);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.texture, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  GLState::BindFramebuffer(0);
+  return d;
 }
 
-glm::mat4 BuildBulletBaseModel(const Bullet& b) {
-  using namespace glm;
-  const mat4 T   = translate(mat4(1.f), b.position());
-  const mat4 S   = scale(mat4(1.f), vec3(0.01f));
-  return T * S;
+// one layer, to render into or copy like a plain DepthMap
+DepthMap Layer(const DepthMapArray& d, int layer) {
+  DepthMap m;
+  m.texture = d.texture;
+  m.fbo = d.fbos[layer];
+  m.size = d.size;
+  return m;
 }
 
-glm::mat4 BuildFloorBaseModel() {
-  using namespace glm;
-  const mat4 T = translate(mat4(1.f), vec3(0.f, -3.f, 0.f));
-  const mat4 S = scale(mat4(1.f), vec3(40.f, 0.3f, 40.f));
-  return T * S;
+// copies one depth map into another of the same size, leaving `to` bound
+void CopyDepthMap(const DepthMap& from, const DepthMap& to) {
+  GLState::BindFramebuffer(to.fbo);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, from.fbo);
+  glBlitFramebuffer(0, 0, from.size, from.size, 0, 0, to.size, to.size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, to.fbo);   // back to what GLState has bound
 }
 
-glm::mat4 BuildTankModel(const glm::vec3& pos, const glm::vec3& lookDir) {
-  using namespace glm;
-  glm::vec3 f = lookDir;
-  f.y = 0.0f; f = glm::normalize(f);
+void BindShadowMap(GLuint sunCascadesTex, GLuint spotShadowsTex) {
+  GLState::BindTexture(1, GL_TEXTURE_2D_ARRAY, sunCascadesTex);
+  GLState::BindTexture(2, GL_TEXTURE_2D_ARRAY, spotShadowsTex);
+}
 
-  float yaw = -std::atan2(f.x, -f.z);          
-  const glm::mat4 T   = glm::translate(glm::mat4(1.f), pos);
-  const glm::mat4 Y   = glm::rotate(glm::mat4(1.f), yaw, glm::vec3(0,1,0));
-  const glm::mat4 Fix = glm::rotate(glm::mat4(1.f), radians(180.f), vec3(0,1,0));
-  const glm::mat4 S   = glm::mat4(1.f);
 
-  return T * Y * Fix * S;
-}
-void DrawFloorShadowOnly(const Mesh& floorMesh, GLuint shaderShadow, const glm::mat4& lightProjView)
-{ 
-  using namespace glm;
-  const mat4 floorModel = BuildFloorBaseModel();
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * floorModel);
-
-  glBindVertexArray(floorMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, floorMesh.vertices);
-  glBindVertexArray(0);
-}
+GLuint LoadTexture2D(const std::string& path);
 
-void DrawTankShadowOnly(const glm::vec3& pos, const glm::vec3& lookDir,
-                               const Mesh& tankMesh, GLuint shaderShadow,
-                               const glm::mat4& lightProjView)
-{
-  using namespace glm;
-  const mat4 model = BuildTankModel(pos, lookDir);
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * model);
-  glBindVertexArray(tankMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, tankMesh.vertices);
-  glBindVertexArray(0);
-}
 
-void DrawCubeShadowOnly(const Mesh& cubeMesh, GLuint shaderShadow, const glm::mat4& lightProjView)
-{ 
-  using namespace glm;
-  const mat4 cubeModel = scale(mat4(1.f), vec3(2.f)) * translate(mat4(1.f), vec3(0.f, -.5f, 20.f)) * rotate(mat4(1.f), radians(45.f), normalize(vec3(1,1,1)));
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * cubeModel);
 
-  glBindVertexArray(cubeMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, cubeMesh.vertices);
-  glBindVertexArray(0);
+// the light matrices a layered shadow pass projects into, one per layer
+void SetShadowLayers(GLuint shaderShadowLayered, const glm::mat4* matrices, int count) {
+  static const char* const names[MAX_SHADOW_LAYERS] = {
+    "layer_matrices[0]", "layer_matrices[1]", "layer_matrices[2]", "layer_matrices[3]",
+    "layer_matrices[4]", "layer_matrices[5]", "layer_matrices[6]", "layer_matrices[7]" };
+  for (int i = 0; i < count && i < MAX_SHADOW_LAYERS; ++i) SetUniformMat4(shaderShadowLayered, names[i], matrices[i]);
 }
 
-inline void DrawTankSceneOnly(const glm::vec3& pos, const glm::vec3& lookDir,
-                              const Mesh& tankMesh, GLuint shaderScene)
+// the mesh's bounding sphere through a model matrix; the radius grows by
+// the largest axis scale, so it stays a bound under non-uniform scaling
+glm::vec4 WorldSphere(const Mesh& mesh, const glm::mat4& model)
 {
-  using namespace glm;
-  const mat4 model = BuildTankModel(pos, lookDir);
-  SetUniformMat4(shaderScene, "model_matrix", model);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, tankMesh.texture);
-  glBindVertexArray(tankMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, tankMesh.vertices);
-  glBindVertexArray(0);
+  const glm::vec3 c = glm::vec3(model * glm::vec4(mesh.sphereCenter, 1.f));
+  const float s = std::max(glm::length(glm::vec3(model[0])),
+                           std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+  return glm::vec4(c, mesh.sphereRadius * s);
 }
 
-void DrawCubeSceneOnly(const Mesh& cubeMesh, GLuint shaderScene)
-{ 
-  using namespace glm;
-  const mat4 model = scale(mat4(1.f), vec3(2.f)) * translate(mat4(1.f), vec3(0.f, -.5f, 20.f)) * rotate(mat4(1.f), radians(45.f), normalize(vec3(1,1,1)));
-  SetUniformMat4(shaderScene, "model_matrix", model);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, cubeMesh.texture);
-
-  glBindVertexArray(cubeMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, cubeMesh.vertices);
-  glBindVertexArray(0);
-}
-
-
-void DrawFloorSceneOnly(const Mesh& floorMesh, GLuint shaderScene)
-{ 
-  using namespace glm;
-  const mat4 floorModel = BuildFloorBaseModel();
-  SetUniformMat4(shaderScene, "model_matrix", floorModel);
-
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, floorMesh.texture);
-
-  glBindVertexArray(floorMesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, floorMesh.vertices);
-  glBindVertexArray(0);
-}
- void DrawPlaneShadowOnly(const Airplane& p,
-                                const PlaneMeshes& mesh,
-                                GLuint shaderShadow,
-                                const glm::mat4& lightProjView,
-                                float propSpinDeg)
+// render queue items (model matrices live in SceneMath.hpp); submit them to
+// a RenderQueue and flush it once per pass
+RenderItem MeshItem(const Mesh& mesh, const glm::mat4& model, GLuint shaderScene,
+                    std::uint8_t passes = PASS_ALL, const glm::vec2& uvScale = glm::vec2(1.f))
 {
-  using namespace glm;
-  const mat4 base = BuildPlaneBaseModel(p);
-
-  const mat4 planeModel = base;
-  const mat4 propModel  = base *
-      translate(mat4(1.f), vec3(0.f, -15.0f, 0.8f)) *
-      rotate(mat4(1.f), radians(propSpinDeg * 50.f), vec3(0,1,0)) *
-      scale(mat4(1.f), vec3(1.3f));
-
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * planeModel);
-  glBindVertexArray(mesh.plane.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.plane.vertices);
-  glBindVertexArray(0);
-
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * propModel);
-  glBindVertexArray(mesh.prop.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.prop.vertices);
-  glBindVertexArray(0);
+  RenderItem item;
+  item.program = shaderScene;
+  item.vao = mesh.vao;
+  item.count = mesh.vertices;
+  item.texture = mesh.texture;
+  item.uvScale = uvScale;
+  item.model = model;
+  item.normalMatrix = NormalMatrix(model);
+  item.passes = passes;
+  item.bounds = WorldSphere(mesh, model);
+  return item;
 }
 
-void DrawPlaneSceneOnly(const Airplane& p,
-                               const PlaneMeshes& mesh,
-                               GLuint shaderScene,
-                               float propSpinDeg)
+// a plane and its propeller, which the vertex shader spins by propPhase
+void SubmitPlane(RenderQueue& queue, const glm::mat4& base, const PlaneMeshes& mesh,
+                 GLuint shaderScene, float propPhase)
 {
-  using namespace glm;
-  const mat4 base = BuildPlaneBaseModel(p);
-
-  const mat4 planeModel = base;
-  const mat4 propModel  = base *
-      translate(mat4(1.f), vec3(0.f, -15.0f, 0.8f)) *
-      rotate(mat4(1.f), radians(propSpinDeg * 50.f), vec3(0,1,0)) *
-      scale(mat4(1.f), vec3(1.3f));
-
-  // plane
-  SetUniformMat4(shaderScene, "model_matrix", planeModel);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, mesh.plane.texture);
-  glBindVertexArray(mesh.plane.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.plane.vertices);
-  glBindVertexArray(0);
-
-  // prop
-  SetUniformMat4(shaderScene, "model_matrix", propModel);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, mesh.prop.texture);
-  glBindVertexArray(mesh.prop.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.prop.vertices);
-  glBindVertexArray(0);
+  queue.submit(MeshItem(mesh.plane, base, shaderScene));
+  RenderItem prop = MeshItem(mesh.prop, base, shaderScene);
+  prop.instanceMode = 2;
+  prop.propPhase = propPhase;
+  // bounds of the propeller at any phase: scene_vertex.glsl places it at
+  // base * translate(0, -15, 0.8) * rotateY(phase) * scale(1.3), so widen
+  // its sphere to cover the circle the spin sweeps it round
+  Mesh swept = mesh.prop;
+  swept.sphereRadius += std::hypot(swept.sphereCenter.x, swept.sphereCenter.z);
+  swept.sphereCenter = glm::vec3(0.f, swept.sphereCenter.y, 0.f);
+  const glm::mat4 hub = glm::scale(glm::translate(glm::mat4(1.f), glm::vec3(0.f, -15.f, 0.8f)), glm::vec3(1.3f));
+  prop.bounds = WorldSphere(swept, base * hub);
+  queue.submit(prop);
 }
 
+// bullets as point sprites: every live position streamed into one buffer
+// and drawn with a single GL_POINTS call (Shaders/bullet_*.glsl)
+struct SpriteBuffer {
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  int capacity = 0;
+  int count = 0;         // sprites uploaded last
+};
 
- void DrawBulletShadowOnly(const Bullet& b,
-                                const Mesh& mesh,
-                                GLuint shaderShadow,
-                                const glm::mat4& lightProjView)
-{
-  using namespace glm;
-  const mat4 bulletModel = BuildBulletBaseModel(b);
-
-  SetUniformMat4(shaderShadow, "transform_in_light_space", lightProjView * bulletModel);
-  glBindVertexArray(mesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.vertices);
-  glBindVertexArray(0);
+SpriteBuffer CreateSpriteBuffer(int capacity) {
+  SpriteBuffer b; b.capacity = capacity;
+  glGenVertexArrays(1, &b.vao);
+  GLState::BindVertexArray(b.vao);
+  glGenBuffers(1, &b.vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+  glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+  glEnableVertexAttribArray(0);
+  GLState::BindVertexArray(0);
+  glEnable(GL_PROGRAM_POINT_SIZE);   // size comes from the vertex shader
+  return b;
 }
 
+// once per frame; orphans the buffer so the driver doesn't wait on last frame's draw
+void UploadSprites(SpriteBuffer& b, const glm::vec3* positions, int count) {
+  b.count = std::min(count, b.capacity);
+  glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+  glBufferData(GL_ARRAY_BUFFER, b.capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, b.count * sizeof(glm::vec3), positions);
+}
 
-void DrawBulletSceneOnly(const Bullet& b,
-                               const Mesh& mesh,
-                               GLuint shaderScene)
+// the uploaded sprites as one scene-pass item; view and projection come
+// from the FrameUniforms block
+RenderItem SpriteItem(const SpriteBuffer& b, GLuint shaderBullet)
 {
-  using namespace glm;
-  const mat4 base = BuildBulletBaseModel(b);
-
-  const mat4 bulletModel = base;
-
-
-
-  SetUniformMat4(shaderScene, "model_matrix", bulletModel);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, mesh.texture);
-  glBindVertexArray(mesh.vao);
-  glDrawArrays(GL_TRIANGLES, 0, mesh.vertices);
-  glBindVertexArray(0);
+  RenderItem item;
+  item.program = shaderBullet;
+  item.vao = b.vao;
+  item.primitive = GL_POINTS;
+  item.count = b.count;
+  item.instanceMode = 0;   // positions are already in world space
+  item.passes = PASS_SCENE;
+  return item;
 }
 
 
@@ -345,7 +329,7 @@ GLuint LoadTexture2D(const std::string& path) {
 
   GLuint tex = 0;
   glGenTextures(1, &tex);
-  glBindTexture(GL_TEXTURE_2D, tex);
+  GLState::BindTexture(0, GL_TEXTURE_2D, tex);
 
   if (data) {
     GLenum fmt = GL_RGB;